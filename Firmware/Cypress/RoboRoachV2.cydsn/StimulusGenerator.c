@@ -36,6 +36,24 @@ const uint32 SEC = 1000;//ms
 const uint32 DAC_MAX = 612;//microA
     
 const double RAND_FREQ_MAPFACTOR = 0.575;
+
+//wiper code for each gain percent, same values as userGain * 2.55 truncated
+static const uint8 GAIN_TABLE[101] = {
+    0, 2, 5, 7, 10, 12, 15, 17, 20, 22,
+    25, 28, 30, 33, 35, 38, 40, 43, 45, 48,
+    51, 53, 56, 58, 61, 63, 66, 68, 71, 73,
+    76, 79, 81, 84, 86, 89, 91, 94, 96, 99,
+    102, 104, 107, 109, 112, 114, 117, 119, 122, 124,
+    127, 130, 132, 135, 137, 140, 142, 145, 147, 150,
+    153, 155, 158, 160, 163, 165, 168, 170, 173, 175,
+    178, 181, 183, 186, 188, 191, 193, 196, 198, 201,
+    204, 206, 209, 211, 214, 216, 219, 221, 224, 226,
+    229, 232, 234, 237, 239, 242, 244, 247, 249, 252,
+    254
+};
+
+//per-board gain table, NULL to use GAIN_TABLE
+static const uint8 * gainCalibration = NULL;
     
 //definitions of functions declared in StimulusGenerator.h
 void StimulusGenerator_Initialize(struct StimulusGenerator * this) {
@@ -185,8 +203,29 @@ uint8 RandomChar(struct StimulusGenerator * this) {
 }
 
 uint8 mapPercentToChar(uint8 userGain) {
-   return userGain * 2.55; 
     
-}
+    //gain is a percentage, anything above is full gain
+    if (userGain > 100) {
+        
+        userGain = 100;
+        
+    }
+    
+    if (gainCalibration != NULL) {
+        
+        return gainCalibration[userGain];
+        
+    }
+    
+    return GAIN_TABLE[userGain];
+    
+}//mapPercentToChar
+
+void SetGainCalibration(const uint8 * table) {
+    
+    //table holds 101 wiper codes and must stay valid, NULL restores GAIN_TABLE
+    gainCalibration = table;
+    
+}//SetGainCalibration
 
 /* [] END OF FILE */
@@ -98,5 +98,7 @@ uint8 RandomChar(struct StimulusGenerator * this);
 
 uint8 mapPercentToChar(uint8 userGain);
 
+void SetGainCalibration(const uint8 * table);
+
 #endif
 /* [] END OF FILE */
@@ -204,12 +204,74 @@ void startStimulus(enum Direction dir)
     stimulationActive = 1;
 }
 
+//
+// Applies a characteristic write, with or without response
+//
+void HandleWrite(CYBLE_GATTS_WRITE_REQ_PARAM_T *wrReq) {
+    
+    //handle left stimulus input, simply sets true whevenever the property is written to
+    if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_STIMLEFT_CHAR_HANDLE) {
+        
+        CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+        startStimulus(Left);
+       
+    }
+    //handle right stimulus input
+    if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_STIMRIGHT_CHAR_HANDLE) {
+        
+        CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+        
+        startStimulus(Right);
+        
+    }
+    //handle duration input
+    if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_DURATION_CHAR_HANDLE) {
+        
+        CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+        
+        StimulusGenerator_SetPulseDuration( &generator, wrReq->handleValPair.value.val[0]);
+        
+    }
+    //handle frequency input
+    if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_STIMFREQ_CHAR_HANDLE) {
+        
+        CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+        
+        StimulusGenerator_SetFrequency(&generator, wrReq->handleValPair.value.val[0]);
+        
+    }
+    //handle pulse width input
+    if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_STIMPULSE_CHAR_HANDLE) {
+        
+        CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+        
+        StimulusGenerator_SetPulseWidth(&generator, wrReq->handleValPair.value.val[0]); 
+        
+    }
+    //handle gain input
+    if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_GAIN_CHAR_HANDLE) {
+        
+        CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+        
+        StimulusGenerator_SetPulseGain(&generator, wrReq->handleValPair.value.val[0]); 
+        
+    }
+    //handle random mode input
+    if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_RANDOMMODE_CHAR_HANDLE) {
+        
+        CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
+        
+        StimulusGenerator_SetRandomMode(&generator, wrReq->handleValPair.value.val[0]); 
+        
+    }
+    
+}
+
 //
 // Bluetooth communications handler
 //
 void StackHandler(uint32 eventCode, void* eventParam) {
     
-    CYBLE_GATTS_WRITE_REQ_PARAM_T *wrReq;
     CYBLE_BLESS_CLK_CFG_PARAMS_T clockConfig;
 
     switch(eventCode) {
@@ -251,69 +313,23 @@ void StackHandler(uint32 eventCode, void* eventParam) {
             
         case CYBLE_EVT_GATTS_WRITE_REQ:
             
-            wrReq = (CYBLE_GATTS_WRITE_REQ_PARAM_T*)eventParam;
-            
-            //handle left stimulus input, simply sets true whevenever the property is written to
-            if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_STIMLEFT_CHAR_HANDLE) {
-                
-                CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
-                startStimulus(Left);
-               
-            }
-            //handle right stimulus input
-            if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_STIMRIGHT_CHAR_HANDLE) {
-                
-                CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
-                
-                startStimulus(Right);
-                
-            }
-            //handle duration input
-            if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_DURATION_CHAR_HANDLE) {
-                
-                CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
-                
-                StimulusGenerator_SetPulseDuration( &generator, wrReq->handleValPair.value.val[0]);
-                
-            }
-            //handle frequency input
-            if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_STIMFREQ_CHAR_HANDLE) {
-                
-                CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
-                
-                StimulusGenerator_SetFrequency(&generator, wrReq->handleValPair.value.val[0]);
-                
-            }
-            //handle pulse width input
-            if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_STIMPULSE_CHAR_HANDLE) {
-                
-                CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
-                
-                StimulusGenerator_SetPulseWidth(&generator, wrReq->handleValPair.value.val[0]); 
-                
-            }
-            //handle gain input
-            if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_GAIN_CHAR_HANDLE) {
-                
-                CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
-                
-                StimulusGenerator_SetPulseGain(&generator, wrReq->handleValPair.value.val[0]); 
-                
-            }
-            //handle random mode input
-            if (wrReq->handleValPair.attrHandle == CYBLE_ROBOROACH_RANDOMMODE_CHAR_HANDLE) {
-                
-                CyBle_GattsWriteAttributeValue(&wrReq->handleValPair, 0, &connectionHandle, CYBLE_GATT_DB_LOCALLY_INITIATED);
-                
-                StimulusGenerator_SetRandomMode(&generator, wrReq->handleValPair.value.val[0]); 
-                
-            }
+            HandleWrite((CYBLE_GATTS_WRITE_REQ_PARAM_T*)eventParam);
             
             CyBle_GattsWriteRsp(connectionHandle);
             sleepCountdown = SLEEP_TIMER_ACTIVE;
             
             break;
             
+        case CYBLE_EVT_GATTS_WRITE_CMD_REQ:
+            
+            //write without response: same handling, but nothing is sent back
+            //so several steering commands fit in one connection event
+            HandleWrite((CYBLE_GATTS_WRITE_CMD_REQ_PARAM_T*)eventParam);
+            
+            sleepCountdown = SLEEP_TIMER_ACTIVE;
+            
+            break;
+            
         default:
             
             break;
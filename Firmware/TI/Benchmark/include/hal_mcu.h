@@ -0,0 +1,40 @@
+/**************************************************************************************************
+  Filename:       hal_mcu.h
+
+  Description:    CC254x MCU abstraction for the SDCC benchmark build: critical
+                  sections and interrupt service routine declarations.
+
+**************************************************************************************************/
+
+#ifndef _HAL_MCU_H
+#define _HAL_MCU_H
+
+#include "hal_types.h"
+#include "ioCC2540.h"
+
+typedef uint8 halIntState_t;
+
+#ifndef st
+  #define st(x)      do { x } while (__LINE__ == -1)
+#endif
+
+#define HAL_ENABLE_INTERRUPTS()         st( EA = 1; )
+#define HAL_DISABLE_INTERRUPTS()        st( EA = 0; )
+#define HAL_INTERRUPTS_ARE_ENABLED()    (EA)
+
+#define HAL_ENTER_CRITICAL_SECTION(x)   st( x = EA;  EA = 0; )
+#define HAL_EXIT_CRITICAL_SECTION(x)    st( EA = x; )
+#define HAL_CRITICAL_STATEMENT(x)       st( halIntState_t _s; HAL_ENTER_CRITICAL_SECTION(_s); x; HAL_EXIT_CRITICAL_SECTION(_s); )
+
+#if defined ( __SDCC )
+  #define HAL_ISR_FUNC_DECLARATION(f,v) void f( void ) __interrupt( v )
+  #define HAL_ISR_FUNC_PROTOTYPE(f,v)   void f( void ) __interrupt( v )
+#else
+  #define HAL_ISR_FUNC_DECLARATION(f,v) void f( void )
+  #define HAL_ISR_FUNC_PROTOTYPE(f,v)   void f( void )
+#endif
+#define HAL_ISR_FUNCTION(f,v)           HAL_ISR_FUNC_DECLARATION(f,v)
+
+#define HAL_MCU_CC2541
+
+#endif
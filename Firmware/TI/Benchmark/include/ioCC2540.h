@@ -0,0 +1,90 @@
+/**************************************************************************************************
+  Filename:       ioCC2540.h
+
+  Description:    CC254x special function registers for the SDCC benchmark build,
+                  limited to the ones the RoboRoach sources touch.
+
+                  ucsim runs a plain 8052, so USART0 is mapped onto the 8052 serial
+                  port: U0CSR on SCON and U0DBUF on SBUF. After "U0CSR = 0x00" the
+                  port is in mode 0 (synchronous shift register), and bit 1 of SCON
+                  (TI) is set by the simulator when a byte has been shifted out,
+                  like TX_BYTE of U0CSR, so the SPI busy-waits terminate. The byte
+                  time differs from the real 480 kHz SPI clock; see README.md.
+                  The USART0 RX interrupt (vector 2) is INT1 on the 8052,
+                  whose pin nothing drives, so queued digipot writes only
+                  move when the harness calls potSpiIsr(). URX0IF and URX0IE
+                  land on the INT1 flag and enable bits.
+
+                  The host check build (no __SDCC) declares every register as a
+                  plain byte so the harness can be compiled and linked with gcc.
+
+**************************************************************************************************/
+
+#ifndef IOCC2540_H
+#define IOCC2540_H
+
+#include <stdint.h>
+
+/* Interrupt vectors (IAR numbering, same as SDCC) */
+#define T1_VECTOR       9
+#define URX0_VECTOR     2
+
+/* name, SFR address */
+#define BENCH_SFRS( X ) \
+  X( P0,        0x80 ) X( P1,        0x90 ) X( P2,        0xA0 ) \
+  X( PERCFG,    0xF1 ) X( P0SEL,     0xF3 ) X( P1SEL,     0xF4 ) X( P2SEL,     0xF5 ) \
+  X( P0DIR,     0xFD ) X( P1DIR,     0xFE ) X( P2DIR,     0xFF ) \
+  X( U0DBUF,    0x99 ) X( U0GCR,     0xC5 ) X( U0BAUD,    0xC2 ) \
+  X( T1CTL,     0xE4 ) X( T1STAT,    0xAF ) X( T1CNTL,    0xE2 ) \
+  X( T1CC0L,    0xDA ) X( T1CC0H,    0xDB ) X( T1CC1L,    0xDC ) X( T1CC1H,    0xDD ) \
+  X( T1CC2L,    0xDE ) X( T1CC2H,    0xDF ) \
+  X( T1CCTL0,   0xE5 ) X( T1CCTL1,   0xE6 ) X( T1CCTL2,   0xE7 ) X( TIMIF,     0xD8 ) \
+  X( ST0,       0x95 ) X( ST1,       0x96 ) X( ST2,       0x97 )
+
+/* name, XDATA address (CC2541 XREG) */
+#define BENCH_XREGS( X ) \
+  X( T1CCTL3,   0x62A3 ) X( T1CCTL4,   0x62A4 ) \
+  X( T1CC3L,    0x62AC ) X( T1CC3H,    0x62AD ) X( T1CC4L,    0x62AE ) X( T1CC4H,    0x62AF )
+
+/* name, bit address */
+#define BENCH_SBITS( X ) \
+  X( P0_0, 0x80 ) X( P0_1, 0x81 ) X( P0_2, 0x82 ) X( P0_3, 0x83 ) \
+  X( P0_4, 0x84 ) X( P0_5, 0x85 ) X( P0_6, 0x86 ) X( P0_7, 0x87 ) \
+  X( P1_0, 0x90 ) X( P1_1, 0x91 ) X( P1_2, 0x92 ) X( P1_3, 0x93 ) \
+  X( P1_4, 0x94 ) X( P1_5, 0x95 ) X( P1_6, 0x96 ) X( P1_7, 0x97 ) \
+  X( EA,   0xAF ) X( T1IE, 0xB9 ) X( T1IF, 0xC1 ) X( URX0IF, 0x8B ) \
+  X( URX0IE, 0xAA )
+
+#if defined ( __SDCC )
+
+  #define BENCH_SFR( name, addr )     __sfr __at( addr ) name;
+  #define BENCH_XREG( name, addr )    volatile __xdata __at( addr ) uint8_t name;
+  #define BENCH_SBIT( name, addr )    __sbit __at( addr ) name;
+
+  BENCH_SFRS( BENCH_SFR )
+  BENCH_XREGS( BENCH_XREG )
+  BENCH_SBITS( BENCH_SBIT )
+  BENCH_SFR( U0CSR, 0x98 )
+
+  // The spin on the SPI queue (potWaitIdle) stands in for the RX interrupt
+  extern void benchNop( void );
+  #define asm( x )                    benchNop()
+
+#else
+
+  #define BENCH_EXTERN( name, addr )  extern volatile uint8_t name;
+
+  BENCH_SFRS( BENCH_EXTERN )
+  BENCH_XREGS( BENCH_EXTERN )
+  BENCH_SBITS( BENCH_EXTERN )
+
+  /* Reads back with TX_BYTE set, so the SPI busy-waits end at once */
+  extern volatile uint8_t *benchU0CSR( void );
+  #define U0CSR                       ( *benchU0CSR() )
+
+  extern void benchNop( void );
+  #define asm( x )                    benchNop()
+
+#endif
+
+#endif
@@ -0,0 +1,62 @@
+/**************************************************************************************************
+  Filename:       bench.h
+
+  Description:    Cycle counting harness for the RoboRoach stimulation hot paths.
+                  The firmware sources are compiled with SDCC and run in the ucsim
+                  8052 simulator; Timer 0 counts machine cycles around each call
+                  and the results are left as text in XDATA for the Makefile to
+                  dump.
+
+**************************************************************************************************/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Calls per benchmark; the report is the mean
+#define BENCH_CALLS             8
+
+// Report buffer, read back with "dump xram" by the Makefile
+#define BENCH_REPORT_ADDR       0xF000
+#define BENCH_REPORT_LEN        0x0F00
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  const char *name;
+  void (*pfnSetup)( void );     // run before every call, not counted; may be NULL
+  void (*pfnCall)( void );      // the measured call
+} benchEntry_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Benchmarks in roboRoachApp.c and MCP4000.c (bench_app.c)
+ */
+extern void benchAppInit( void );
+extern const benchEntry_t benchAppEntries[];
+extern const uint8 benchAppNumEntries;
+
+/*
+ * Benchmarks in roboRoach_GATTprofile.c (bench_profile.c)
+ */
+extern void benchProfileInit( void );
+extern const benchEntry_t benchProfileEntries[];
+extern const uint8 benchProfileNumEntries;
+
+/*
+ * Reached once the report is complete; stops the simulator
+ */
+extern void benchDone( void );
+
+#endif /* BENCH_H */
@@ -0,0 +1,188 @@
+/**************************************************************************************************
+  Filename:       bench_app.c
+
+  Description:    Benchmarks of the application's stimulation paths. The source is
+                  included so its static functions can be called directly:
+
+                    fillRoboRoachSchedule         random train, a full ring of
+                                                  16 drawn pulses
+                    startRoboRoachStimulation     random and fixed trains, from
+                                                  the profile values to Timer 1
+                                                  running, or to the first gain
+                                                  queued when it is new
+                    roboRoachApp_HandlePotDone    first Timer 1 edge once the
+                                                  gain writes are done
+                    roboRoachApp_HandlePulseOn    one OSAL pulse edge, gain
+                                                  written in the gap
+                    Gain_SetLevel                 new gain (both wipers
+                                                  queued for SPI) and unchanged
+                                                  gain
+                    spiWriteByte                  one byte to the MCP4251
+
+**************************************************************************************************/
+
+#include "roboRoachApp.c"
+
+#include "bench.h"
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+// MCP4000.c, not in its header
+extern void spiWriteByte( uint8 write );
+extern HAL_ISR_FUNC_PROTOTYPE( potSpiIsr, URX0_VECTOR );
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint8 benchGain = 40;
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+// asm("NOP") in the firmware: the spin on the SPI queue sends the next
+// byte, as the RX interrupt would
+void benchNop( void )
+{
+  if ( potBusy() )
+  {
+    potSpiIsr();
+  }
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+// Sends the queued digipot writes; no RX interrupt fires in the harness
+static void benchDrainPot( void )
+{
+  while ( potBusy() )
+  {
+    potSpiIsr();
+  }
+}
+
+static void benchSetProfile( uint8 randomMode )
+{
+  uint8 value;
+
+  RoboRoachProfile_SetParameter( ROBOROACH_RANDOM_MODE, 1, &randomMode );
+  value = 50;
+  RoboRoachProfile_SetParameter( ROBOROACH_FREQUENCY, 1, &value );
+  value = 10;
+  RoboRoachProfile_SetParameter( ROBOROACH_PULSE_WIDTH, 1, &value );
+  value = 200;
+  RoboRoachProfile_SetParameter( ROBOROACH_DURATION, 1, &value );
+  loadRoboRoachParams();
+}
+
+// Random train of 40..100 Hz, 1..9 ms, 50..80 % gain, one second long
+static void benchSetupRandomFill( void )
+{
+  pStimActive->randomMode = 1;
+  pStimActive->duration = 200;
+  stimulationCurrentDuration = 0;
+  stimulationPeriodMin = 10;
+  stimulationPeriodSpan = 15;
+  stimulationPWMin = 1;
+  stimulationPWSpan = 8;
+  stimulationGainMin = 50;
+  stimulationGainSpan = 30;
+  RoboRoachPulse_Open( ROBOROACH_ANTENNA_LEFT_T1_CHANNEL, 25000UL );
+}
+
+static void benchSetupStartRandom( void )
+{
+  RoboRoachPulse_Stop();
+  benchDrainPot();
+  stimulationGainWait = FALSE;
+  benchSetProfile( 1 );
+  stimulationIsLeft = 1;
+}
+
+static void benchSetupStartFixed( void )
+{
+  RoboRoachPulse_Stop();
+  benchDrainPot();
+  stimulationGainWait = FALSE;
+  benchSetProfile( 0 );
+  stimulationIsLeft = 1;
+}
+
+// A Timer 1 train waiting for the writes of a new gain, which are out
+static void benchSetupPotDone( void )
+{
+  RoboRoachPulse_Stop();
+  stimulationMode = RoboRoachPulse_Open( ROBOROACH_ANTENNA_LEFT_T1_CHANNEL, 25000UL );
+  RoboRoachPulse_Push( 20000UL, 1000UL, benchGain, 10 );
+  RoboRoachPulse_Close();
+  Gain_SetLevel( benchGain );
+  benchGain = ( benchGain == 40 ) ? 60 : 40;
+  benchDrainPot();
+  stimulationGainWait = TRUE;
+}
+
+// An OSAL train with one 500 ms period left, its gain already on the wipers
+static void benchSetupPulseOn( void )
+{
+  RoboRoachPulse_Stop();
+  stimulationMode = RoboRoachPulse_Open( ROBOROACH_T1_CHANNEL_NONE, 500000UL );
+  RoboRoachPulse_Push( 500000UL, 10000UL, benchGain, 2 );
+  RoboRoachPulse_Close();
+  Gain_SetLevel( benchGain );
+  benchDrainPot();
+  stimulationGainWait = FALSE;
+  stimulationIsLeft = 1;
+}
+
+static void benchSetupGainChanged( void )
+{
+  benchGain = ( benchGain == 40 ) ? 60 : 40;
+  benchDrainPot();
+}
+
+static void benchSetupGainUnchanged( void )
+{
+  benchDrainPot();
+}
+
+static void benchGainSetLevel( void )
+{
+  Gain_SetLevel( benchGain );
+}
+
+static void benchSpiWriteByte( void )
+{
+  spiWriteByte( 0x5A );
+}
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+void benchAppInit( void )
+{
+  roboRoachApp_TaskID = 0;
+  RoboRoachTimer_Init( roboRoachApp_TaskID );
+  RoboRoachPulse_Init( roboRoachApp_TaskID, BYB_STIMULATE_FINISHED_EVT,
+                       BYB_STIMULATE_REFILL_EVT );
+  potInit();
+}
+
+const benchEntry_t benchAppEntries[] =
+{
+  { "fillRoboRoachSchedule_random",     benchSetupRandomFill,    fillRoboRoachSchedule },
+  { "startRoboRoachStimulation_random", benchSetupStartRandom,   startRoboRoachStimulation },
+  { "startRoboRoachStimulation_fixed",  benchSetupStartFixed,    startRoboRoachStimulation },
+  { "roboRoachApp_HandlePotDone",       benchSetupPotDone,       roboRoachApp_HandlePotDone },
+  { "roboRoachApp_HandlePulseOn",       benchSetupPulseOn,       roboRoachApp_HandlePulseOn },
+  { "Gain_SetLevel_changed",            benchSetupGainChanged,   benchGainSetLevel },
+  { "Gain_SetLevel_unchanged",          benchSetupGainUnchanged, benchGainSetLevel },
+  { "spiWriteByte",                     NULL,                    benchSpiWriteByte },
+};
+
+const uint8 benchAppNumEntries = sizeof( benchAppEntries ) / sizeof( benchAppEntries[0] );
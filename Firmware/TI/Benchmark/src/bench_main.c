@@ -0,0 +1,210 @@
+/**************************************************************************************************
+  Filename:       bench_main.c
+
+  Description:    Runs every benchmark and writes one line per entry to the
+                  report buffer:
+
+                    <name> <calls> <cycles per call>
+
+                  Under SDCC the cycles are 8052 machine cycles counted by Timer 0
+                  (mode 1, overflows counted in its interrupt), with the cost of
+                  starting and stopping the count taken off. The host build
+                  (make host) only checks that the harness links and every
+                  benchmark returns; it prints the report with zero cycles.
+
+**************************************************************************************************/
+
+#include "hal_mcu.h"
+
+#include "bench.h"
+
+#if !defined ( __SDCC )
+  #include <stdio.h>
+#endif
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if defined ( __SDCC )
+// 8052 Timer 0, not present on the CC2541 but modeled by ucsim
+__sfr  __at( 0x89 ) TMOD;
+__sfr  __at( 0x8A ) TL0;
+__sfr  __at( 0x8C ) TH0;
+__sbit __at( 0x8C ) TR0;
+__sbit __at( 0xA9 ) ET0;
+#endif
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+#if defined ( __SDCC )
+static __xdata __at( BENCH_REPORT_ADDR ) char benchReport[BENCH_REPORT_LEN];
+static volatile uint16 benchOverflows;
+#else
+static char benchReport[BENCH_REPORT_LEN];
+#endif
+
+static uint16 benchReportLen = 0;
+static uint32 benchOverhead = 0;
+
+/*********************************************************************
+ * Cycle counter
+ */
+
+#if defined ( __SDCC )
+void benchTimer0Isr( void ) __interrupt( 1 )
+{
+  benchOverflows++;
+}
+#endif
+
+static void benchStart( void )
+{
+#if defined ( __SDCC )
+  TR0 = 0;
+  TH0 = 0;
+  TL0 = 0;
+  benchOverflows = 0;
+  TR0 = 1;
+#endif
+}
+
+static uint32 benchStop( void )
+{
+#if defined ( __SDCC )
+  TR0 = 0;
+  return ( ( (uint32)benchOverflows << 16 ) | ( (uint16)TH0 << 8 ) | TL0 );
+#else
+  return ( 0 );
+#endif
+}
+
+static void benchNothing( void )
+{
+}
+
+/*********************************************************************
+ * Report
+ */
+
+static void benchPutc( char c )
+{
+  if ( benchReportLen < BENCH_REPORT_LEN - 1 )
+  {
+    benchReport[benchReportLen++] = c;
+    benchReport[benchReportLen] = '\0';
+  }
+}
+
+static void benchPuts( const char *s )
+{
+  while ( *s )
+  {
+    benchPutc( *s++ );
+  }
+}
+
+static void benchPutNum( uint32 value )
+{
+  char digits[10];
+  uint8 n = 0;
+
+  do
+  {
+    digits[n++] = (char)( '0' + ( value % 10 ) );
+    value /= 10;
+  } while ( value );
+
+  while ( n )
+  {
+    benchPutc( digits[--n] );
+  }
+}
+
+/*********************************************************************
+ * Runner
+ */
+
+static uint32 benchMeasure( const benchEntry_t *pEntry )
+{
+  uint32 total = 0;
+  uint8 i;
+
+  for ( i = 0; i < BENCH_CALLS; i++ )
+  {
+    uint32 cycles;
+
+    if ( pEntry->pfnSetup )
+    {
+      pEntry->pfnSetup();
+    }
+    benchStart();
+    pEntry->pfnCall();
+    cycles = benchStop();
+    total += ( cycles > benchOverhead ) ? ( cycles - benchOverhead ) : 0;
+  }
+  return ( ( total + BENCH_CALLS / 2 ) / BENCH_CALLS );
+}
+
+static void benchRun( const benchEntry_t *pEntries, uint8 count )
+{
+  uint8 i;
+
+  for ( i = 0; i < count; i++ )
+  {
+    uint32 cycles = benchMeasure( &pEntries[i] );
+
+    benchPuts( pEntries[i].name );
+    benchPutc( ' ' );
+    benchPutNum( BENCH_CALLS );
+    benchPutc( ' ' );
+    benchPutNum( cycles );
+    benchPutc( '\n' );
+  }
+}
+
+void benchDone( void )
+{
+#if defined ( __SDCC )
+  // 0xA5 is not an 8051 instruction: ucsim stops the run here
+  __asm
+    .db 0xA5
+  __endasm;
+  for ( ;; )
+  {
+  }
+#else
+  fputs( benchReport, stdout );
+#endif
+}
+
+/*********************************************************************
+ * Main
+ */
+
+int main( void )
+{
+  static const benchEntry_t calibrate = { "overhead", NULL, benchNothing };
+
+#if defined ( __SDCC )
+  TMOD = ( TMOD & 0xF0 ) | 0x01;    // Timer 0: 16-bit, counts machine cycles
+  ET0 = 1;
+#endif
+  HAL_ENABLE_INTERRUPTS();
+
+  benchReportLen = 0;
+  benchReport[0] = '\0';
+  benchOverhead = 0;
+  benchOverhead = benchMeasure( &calibrate );
+
+  benchAppInit();
+  benchRun( benchAppEntries, benchAppNumEntries );
+
+  benchProfileInit();
+  benchRun( benchProfileEntries, benchProfileNumEntries );
+
+  benchDone();
+  return ( 0 );
+}
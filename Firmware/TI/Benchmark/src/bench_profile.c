@@ -0,0 +1,80 @@
+/**************************************************************************************************
+  Filename:       bench_profile.c
+
+  Description:    Benchmarks of the profile's write path. The source is included
+                  so the attribute table and its static callbacks can be reached:
+
+                    roboRoachProfile_WriteAttrCB  frequency (1 byte, accepted),
+                                                  frequency with a bad length
+                                                  (rejected by validation) and
+                                                  the 16 byte Stimulation Config
+                    roboRoachProfile_updateStimulationSettings
+
+**************************************************************************************************/
+
+#include "roboRoach_GATTprofile.c"
+
+#include "bench.h"
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static gattAttribute_t *benchFrequencyAttr = NULL;
+static gattAttribute_t *benchConfigAttr = NULL;
+static uint8 benchConfig[ROBOROACH_CONFIG_LEN];
+static uint8 benchFrequency[2] = { 50, 0 };
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static gattAttribute_t *benchFindAttr( uint8 *pValue )
+{
+  uint8 i;
+
+  for ( i = 0; i < SERVAPP_NUM_ATTR_SUPPORTED; i++ )
+  {
+    if ( roboRoachAttrTbl[i].pValue == pValue )
+    {
+      return ( &roboRoachAttrTbl[i] );
+    }
+  }
+  return ( NULL );
+}
+
+static void benchWriteFrequency( void )
+{
+  roboRoachProfile_WriteAttrCB( 0, benchFrequencyAttr, benchFrequency, 1, 0 );
+}
+
+static void benchWriteFrequencyBadLen( void )
+{
+  roboRoachProfile_WriteAttrCB( 0, benchFrequencyAttr, benchFrequency, 2, 0 );
+}
+
+static void benchWriteConfig( void )
+{
+  roboRoachProfile_WriteAttrCB( 0, benchConfigAttr, benchConfig, ROBOROACH_CONFIG_LEN, 0 );
+}
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+void benchProfileInit( void )
+{
+  benchFrequencyAttr = benchFindAttr( &rrCharFrequency );
+  benchConfigAttr = benchFindAttr( &rrCharConfig );
+  roboRoachProfile_PackConfig( benchConfig );
+}
+
+const benchEntry_t benchProfileEntries[] =
+{
+  { "WriteAttrCB_frequency",            NULL, benchWriteFrequency },
+  { "WriteAttrCB_frequency_badlen",     NULL, benchWriteFrequencyBadLen },
+  { "WriteAttrCB_config",               NULL, benchWriteConfig },
+  { "updateStimulationSettings",        NULL, roboRoachProfile_updateStimulationSettings },
+};
+
+const uint8 benchProfileNumEntries = sizeof( benchProfileEntries ) / sizeof( benchProfileEntries[0] );
@@ -0,0 +1,296 @@
+/**************************************************************************************************
+  Filename:       bench_stubs.c
+
+  Description:    Minimal OSAL, BLE stack and service functions for the benchmark
+                  build. None of them does any work: timers and events are not
+                  run, notifications are not sent. Only what the measured paths
+                  call costs anything, and that cost is small and fixed, so it
+                  does not hide a change in the firmware.
+
+                  The host check build also gets the CC254x registers here.
+
+**************************************************************************************************/
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "OSAL_PwrMgr.h"
+#include "OSAL_Timers.h"
+#include "osal_snv.h"
+#include "gap.h"
+#include "gatt.h"
+#include "gatt_uuid.h"
+#include "gattservapp.h"
+#include "gapgattserver.h"
+#include "gapbondmgr.h"
+#include "peripheral.h"
+#include "linkdb.h"
+#include "hci.h"
+#include "hal_adc.h"
+#include "battservice.h"
+#include "devinfoservice.h"
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+CONST uint8 primaryServiceUUID[ATT_BT_UUID_SIZE] =
+  { LO_UINT16( GATT_PRIMARY_SERVICE_UUID ), HI_UINT16( GATT_PRIMARY_SERVICE_UUID ) };
+CONST uint8 characterUUID[ATT_BT_UUID_SIZE] =
+  { LO_UINT16( GATT_CHARACTER_UUID ), HI_UINT16( GATT_CHARACTER_UUID ) };
+CONST uint8 charUserDescUUID[ATT_BT_UUID_SIZE] =
+  { LO_UINT16( GATT_CHAR_USER_DESC_UUID ), HI_UINT16( GATT_CHAR_USER_DESC_UUID ) };
+CONST uint8 clientCharCfgUUID[ATT_BT_UUID_SIZE] =
+  { LO_UINT16( GATT_CLIENT_CHAR_CFG_UUID ), HI_UINT16( GATT_CLIENT_CHAR_CFG_UUID ) };
+
+#if !defined ( __SDCC )
+  #define BENCH_DEFINE( name, addr )  volatile uint8_t name;
+
+  BENCH_SFRS( BENCH_DEFINE )
+  BENCH_XREGS( BENCH_DEFINE )
+  BENCH_SBITS( BENCH_DEFINE )
+
+  static volatile uint8_t benchU0CSRValue;
+
+  volatile uint8_t *benchU0CSR( void )
+  {
+    benchU0CSRValue |= 0x02;
+    return ( &benchU0CSRValue );
+  }
+#endif
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint32 benchRandState = 1;
+
+/*********************************************************************
+ * OSAL
+ */
+
+uint8 osal_set_event( uint8 task_id, uint16 event_flag )
+{
+  return ( SUCCESS );
+}
+
+uint8 osal_clear_event( uint8 task_id, uint16 event_flag )
+{
+  return ( SUCCESS );
+}
+
+uint8 *osal_msg_receive( uint8 task_id )
+{
+  return ( NULL );
+}
+
+uint8 osal_msg_deallocate( uint8 *msg_ptr )
+{
+  return ( SUCCESS );
+}
+
+uint32 osal_GetSystemClock( void )
+{
+  return ( 0 );
+}
+
+// Same generator as the host simulation, so random trains draw the same pulses
+uint16 osal_rand( void )
+{
+  benchRandState = benchRandState * 1103515245UL + 12345UL;
+  return (uint16)( benchRandState >> 16 );
+}
+
+void *osal_memcpy( void *dst, const void GENERIC *src, unsigned int len )
+{
+  uint8 *d = dst;
+  const uint8 *s = src;
+
+  while ( len-- )
+  {
+    *d++ = *s++;
+  }
+  return ( d );
+}
+
+void *osal_memset( void *dest, uint8 value, int len )
+{
+  uint8 *d = dest;
+
+  while ( len-- > 0 )
+  {
+    *d++ = value;
+  }
+  return ( dest );
+}
+
+uint8 osal_memcmp( const void GENERIC *src1, const void GENERIC *src2, unsigned int len )
+{
+  const uint8 *a = src1;
+  const uint8 *b = src2;
+
+  while ( len-- )
+  {
+    if ( *a++ != *b++ )
+    {
+      return ( FALSE );
+    }
+  }
+  return ( TRUE );
+}
+
+uint8 osal_start_timerEx( uint8 task_id, uint16 event_id, uint32 timeout_value )
+{
+  return ( SUCCESS );
+}
+
+uint8 osal_stop_timerEx( uint8 task_id, uint16 event_id )
+{
+  return ( SUCCESS );
+}
+
+uint32 osal_get_timeoutEx( uint8 task_id, uint16 event_id )
+{
+  return ( 0 );
+}
+
+void osal_pwrmgr_init( void )
+{
+}
+
+uint8 osal_pwrmgr_task_state( uint8 task_id, uint8 state )
+{
+  return ( SUCCESS );
+}
+
+void osal_pwrmgr_powerconserve( void )
+{
+}
+
+// Nothing saved: the profile keeps its defaults
+uint8 osal_snv_read( osalSnvId_t id, osalSnvLen_t len, void *pBuf )
+{
+  return ( NV_OPER_FAILED );
+}
+
+uint8 osal_snv_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf )
+{
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * BLE stack and services
+ */
+
+bStatus_t GAP_SetParamValue( uint16 paramID, uint16 paramValue )
+{
+  return ( SUCCESS );
+}
+
+bStatus_t GAPRole_SetParameter( uint16 param, uint8 len, void *pValue )
+{
+  return ( SUCCESS );
+}
+
+bStatus_t GAPRole_GetParameter( uint16 param, void *pValue )
+{
+  return ( SUCCESS );
+}
+
+bStatus_t GAPRole_StartDevice( gapRolesCBs_t *pAppCallbacks )
+{
+  return ( SUCCESS );
+}
+
+bStatus_t GAPBondMgr_SetParameter( uint16 param, uint8 len, void *pValue )
+{
+  return ( SUCCESS );
+}
+
+bStatus_t GAPBondMgr_Register( gapBondCBs_t *pCB )
+{
+  return ( SUCCESS );
+}
+
+bStatus_t GGS_SetParameter( uint8 param, uint8 len, void *value )
+{
+  return ( SUCCESS );
+}
+
+bStatus_t GGS_AddService( uint32 services )
+{
+  return ( SUCCESS );
+}
+
+bStatus_t GATTServApp_RegisterService( gattAttribute_t *pAttrs, uint16 numAttrs,
+                                       CONST gattServiceCBs_t *pServiceCBs )
+{
+  return ( SUCCESS );
+}
+
+bStatus_t GATTServApp_AddService( uint32 services )
+{
+  return ( SUCCESS );
+}
+
+void GATTServApp_InitCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl )
+{
+}
+
+bStatus_t GATTServApp_ProcessCCCWriteReq( uint16 connHandle, gattAttribute_t *pAttr,
+                                          uint8 *pValue, uint8 len, uint16 offset,
+                                          uint16 validCfg )
+{
+  return ( SUCCESS );
+}
+
+bStatus_t GATTServApp_ProcessCharCfg( gattCharCfg_t *charCfgTbl, uint8 *pValue,
+                                      uint8 authenticated, gattAttribute_t *attrTbl,
+                                      uint16 numAttrs, uint8 taskId )
+{
+  return ( SUCCESS );
+}
+
+uint8 linkDB_Register( pfnLinkDBCB_t pFunc )
+{
+  return ( SUCCESS );
+}
+
+uint8 linkDB_State( uint16 connectionHandle, uint8 state )
+{
+  return ( FALSE );
+}
+
+uint8 HCI_EXT_ClkDivOnHaltCmd( uint8 control )
+{
+  return ( SUCCESS );
+}
+
+void HalAdcInit( void )
+{
+}
+
+bStatus_t Batt_AddService( void )
+{
+  return ( SUCCESS );
+}
+
+uint8 Batt_MeasLevel( void )
+{
+  return ( 100 );
+}
+
+bStatus_t Batt_GetParameter( uint8 param, void *value )
+{
+  *(uint8 *)value = 100;
+  return ( SUCCESS );
+}
+
+bStatus_t DevInfo_AddService( void )
+{
+  return ( SUCCESS );
+}
+
+bStatus_t DevInfo_SetParameter( uint8 param, uint8 len, void *value )
+{
+  return ( SUCCESS );
+}
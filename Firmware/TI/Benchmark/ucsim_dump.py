@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""Benchmark report tools.
+
+  ucsim_dump.py LOG
+      Extract the report the benchmark left in XDATA from the output of
+      ucsim's "dump xram ... 16" command and print it.
+
+  ucsim_dump.py --compare BASELINE RESULT
+      Print every entry of RESULT with its cycles in BASELINE and the
+      change in percent. Exit status 1 when an entry got slower.
+"""
+
+import re
+import sys
+
+# "0xf000 66 69 6c 6c ... fill...", possibly after a "0> " prompt
+DUMP_LINE = re.compile(r'^(?:\S*>\s*)?\s*(?:0x)?([0-9a-fA-F]{4,})\s+((?:[0-9a-fA-F]{2}\s+){15}[0-9a-fA-F]{2})\b')
+
+
+def extract(log_path):
+    memory = {}
+    with open(log_path, errors='replace') as log:
+        for line in log:
+            match = DUMP_LINE.match(line)
+            if match:
+                address = int(match.group(1), 16)
+                for i, byte in enumerate(match.group(2).split()):
+                    memory[address + i] = int(byte, 16)
+    if not memory:
+        sys.exit('%s: no memory dump found, see the ucsim output there' % log_path)
+    start = min(memory)
+    data = bytearray(memory.get(a, 0) for a in range(start, max(memory) + 1))
+    end = data.find(0)
+    return bytes(data[:end if end >= 0 else len(data)]).decode('ascii', 'replace')
+
+
+def load(path):
+    entries = {}
+    order = []
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) == 3:
+                entries[fields[0]] = int(fields[2])
+                order.append(fields[0])
+    return order, entries
+
+
+def compare(baseline_path, result_path):
+    _, base = load(baseline_path)
+    order, now = load(result_path)
+    slower = False
+    print('%-36s %10s %10s %8s' % ('entry', 'baseline', 'cycles', 'change'))
+    for name in order:
+        if name in base and base[name]:
+            change = (now[name] - base[name]) * 100.0 / base[name]
+            print('%-36s %10d %10d %+7.1f%%' % (name, base[name], now[name], change))
+            slower = slower or now[name] > base[name]
+        else:
+            print('%-36s %10s %10d %8s' % (name, '-', now[name], 'new'))
+    return 1 if slower else 0
+
+
+def main(argv):
+    if len(argv) == 4 and argv[1] == '--compare':
+        return compare(argv[2], argv[3])
+    if len(argv) == 2:
+        sys.stdout.write(extract(argv[1]))
+        return 0
+    sys.stderr.write(__doc__)
+    return 2
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,37 @@
+/**************************************************************************************************
+  Filename:       OSAL.h
+
+  Description:    Host simulation stand-in for the OSAL API. Events, timers and the
+                  message queue are implemented by the simulator on a virtual clock.
+
+**************************************************************************************************/
+
+#ifndef OSAL_H
+#define OSAL_H
+
+#include "comdef.h"
+#include "OSAL_Timers.h"
+
+#define SYS_EVENT_MSG               0x8000
+#define TASK_NO_TASK                0xFF
+
+typedef struct
+{
+  uint8  event;
+  uint8  status;
+} osal_event_hdr_t;
+
+extern uint8  osal_set_event( uint8 task_id, uint16 event_flag );
+extern uint8  osal_clear_event( uint8 task_id, uint16 event_flag );
+extern uint8 *osal_msg_receive( uint8 task_id );
+extern uint8  osal_msg_deallocate( uint8 *msg_ptr );
+extern uint8 *osal_msg_allocate( uint16 len );
+extern uint8  osal_msg_send( uint8 destination_task, uint8 *msg_ptr );
+extern uint16 osal_rand( void );
+extern void  *osal_memcpy( void *dst, const void GENERIC *src, unsigned int len );
+extern void  *osal_memset( void *dest, uint8 value, int len );
+extern uint8  osal_memcmp( const void GENERIC *src1, const void GENERIC *src2, unsigned int len );
+extern void  *osal_mem_alloc( uint16 size );
+extern void   osal_mem_free( void *ptr );
+
+#endif
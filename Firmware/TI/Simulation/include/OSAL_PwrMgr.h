@@ -0,0 +1,24 @@
+/**************************************************************************************************
+  Filename:       OSAL_PwrMgr.h
+
+  Description:    Host simulation stand-in for the OSAL power manager.
+
+**************************************************************************************************/
+
+#ifndef OSAL_PWRMGR_H
+#define OSAL_PWRMGR_H
+
+#include "comdef.h"
+
+#define PWRMGR_ALWAYS_ON          0
+#define PWRMGR_BATTERY            1
+
+#define PWRMGR_CONSERVE           0
+#define PWRMGR_HOLD               1
+
+extern void  osal_pwrmgr_init( void );
+extern void  osal_pwrmgr_device( uint8 pwrmgr_device );
+extern uint8 osal_pwrmgr_task_state( uint8 task_id, uint8 state );
+extern void  osal_pwrmgr_powerconserve( void );
+
+#endif
@@ -0,0 +1,20 @@
+/**************************************************************************************************
+  Filename:       OSAL_Timers.h
+
+  Description:    Host simulation stand-in for the OSAL timer API.
+
+**************************************************************************************************/
+
+#ifndef OSAL_TIMERS_H
+#define OSAL_TIMERS_H
+
+#include "comdef.h"
+
+extern uint8  osal_start_timerEx( uint8 task_id, uint16 event_id, uint32 timeout_value );
+extern uint8  osal_start_reload_timer( uint8 taskID, uint16 event_id, uint32 timeout_value );
+extern uint8  osal_stop_timerEx( uint8 task_id, uint16 event_id );
+extern uint32 osal_get_timeoutEx( uint8 task_id, uint16 event_id );
+extern uint32 osal_GetSystemClock( void );
+extern uint32 osal_next_timeout( void );
+
+#endif
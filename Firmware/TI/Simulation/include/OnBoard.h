@@ -0,0 +1,30 @@
+/**************************************************************************************************
+  Filename:       OnBoard.h
+
+  Description:    Host simulation stand-in for the board support definitions.
+
+**************************************************************************************************/
+
+#ifndef ONBOARD_H
+#define ONBOARD_H
+
+#include "hal_mcu.h"
+#include "hal_sleep.h"
+#include "osal.h"
+
+#define OB_COLD   0
+#define OB_WARM   1
+#define OB_READY  2
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8 state;
+  uint8 keys;
+} keyChange_t;
+
+#define KEY_CHANGE                0xC0
+
+extern void InitBoard( uint8 level );
+
+#endif
@@ -0,0 +1,19 @@
+/**************************************************************************************************
+  Filename:       battservice.h
+
+  Description:    Host simulation stand-in for the Battery Service.
+
+**************************************************************************************************/
+
+#ifndef BATTSERVICE_H
+#define BATTSERVICE_H
+
+#include "bcomdef.h"
+
+#define BATT_PARAM_LEVEL                 0
+
+extern bStatus_t Batt_AddService( void );
+extern uint8 Batt_MeasLevel( void );
+extern bStatus_t Batt_GetParameter( uint8 param, void *value );
+
+#endif
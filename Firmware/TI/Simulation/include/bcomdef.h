@@ -0,0 +1,38 @@
+/**************************************************************************************************
+  Filename:       bcomdef.h
+
+  Description:    Host simulation stand-in for the BLE stack common definitions.
+
+**************************************************************************************************/
+
+#ifndef BCOMDEF_H
+#define BCOMDEF_H
+
+#include "hal_types.h"
+#include "hal_mcu.h"
+#include "comdef.h"
+
+#define B_ADDR_LEN                    6
+#define KEYLEN                        16
+
+#define bleInvalidTaskID              INVALID_TASK
+#define INVALID_TASK_ID               0xFF
+#define bleNotReady                   0x10
+#define bleAlreadyInRequestedMode     0x11
+#define bleIncorrectMode              0x12
+#define bleMemAllocError              0x13
+#define bleNotConnected               0x14
+#define bleNoResources                0x15
+#define blePending                    0x16
+#define bleTimeout                    0x17
+#define bleInvalidRange               0x18
+#define bleLinkEncrypted              0x19
+#define bleProcedureComplete          0x1A
+
+typedef Status_t bStatus_t;
+
+// Simple NV IDs left to the application
+#define BLE_NVID_CUST_START           0x80
+#define BLE_NVID_CUST_END             0x8F
+
+#endif
@@ -0,0 +1,19 @@
+/**************************************************************************************************
+  Filename:       gapgattserver.h
+
+  Description:    Host simulation stand-in for the GAP GATT server.
+
+**************************************************************************************************/
+
+#ifndef GAPGATTSERVER_H
+#define GAPGATTSERVER_H
+
+#include "bcomdef.h"
+#include "gap.h"
+
+#define GGS_DEVICE_NAME_ATT              0
+
+extern bStatus_t GGS_SetParameter( uint8 param, uint8 len, void *value );
+extern bStatus_t GGS_AddService( uint32 services );
+
+#endif
@@ -0,0 +1,54 @@
+/**************************************************************************************************
+  Filename:       gatt.h
+
+  Description:    Host simulation stand-in for the GATT server definitions.
+
+**************************************************************************************************/
+
+#ifndef GATT_H
+#define GATT_H
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "att.h"
+
+#define GATT_PERMIT_READ                 0x01
+#define GATT_PERMIT_WRITE                0x02
+#define GATT_PERMIT_AUTHEN_READ          0x04
+#define GATT_PERMIT_AUTHEN_WRITE         0x08
+#define GATT_PERMIT_AUTHOR_READ          0x10
+#define GATT_PERMIT_AUTHOR_WRITE         0x20
+
+#define GATT_PROP_BCAST                  0x01
+#define GATT_PROP_READ                   0x02
+#define GATT_PROP_WRITE_NO_RSP           0x04
+#define GATT_PROP_WRITE                  0x08
+#define GATT_PROP_NOTIFY                 0x10
+#define GATT_PROP_INDICATE               0x20
+#define GATT_PROP_AUTHEN                 0x40
+#define GATT_PROP_EXTENDED               0x80
+
+#define GATT_MAX_NUM_CONN                1
+
+#define gattPermitAuthorRead( a )        ( (a) & GATT_PERMIT_AUTHOR_READ )
+#define gattPermitAuthorWrite( a )       ( (a) & GATT_PERMIT_AUTHOR_WRITE )
+
+#define GATT_NUM_ATTRS( attrs )          ( sizeof( attrs ) / sizeof( gattAttribute_t ) )
+
+typedef struct
+{
+  uint8 len;
+  const uint8 *uuid;
+} gattAttrType_t;
+
+typedef struct attAttribute_t
+{
+  gattAttrType_t type;
+  uint8 permissions;
+  uint16 handle;
+  uint8 * const pValue;
+} gattAttribute_t;
+
+extern bStatus_t GATT_Notification( uint16 connHandle, attHandleValueNoti_t *pNoti, uint8 authenticated );
+
+#endif
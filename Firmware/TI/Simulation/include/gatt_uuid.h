@@ -0,0 +1,23 @@
+/**************************************************************************************************
+  Filename:       gatt_uuid.h
+
+  Description:    Host simulation stand-in for the GATT UUID definitions.
+
+**************************************************************************************************/
+
+#ifndef GATT_UUID_H
+#define GATT_UUID_H
+
+#include "att.h"
+
+#define GATT_PRIMARY_SERVICE_UUID        0x2800
+#define GATT_CHARACTER_UUID              0x2803
+#define GATT_CHAR_USER_DESC_UUID         0x2901
+#define GATT_CLIENT_CHAR_CFG_UUID        0x2902
+
+extern CONST uint8 primaryServiceUUID[];
+extern CONST uint8 characterUUID[];
+extern CONST uint8 charUserDescUUID[];
+extern CONST uint8 clientCharCfgUUID[];
+
+#endif
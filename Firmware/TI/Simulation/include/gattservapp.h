@@ -0,0 +1,58 @@
+/**************************************************************************************************
+  Filename:       gattservapp.h
+
+  Description:    Host simulation stand-in for the GATT Server Application.
+
+**************************************************************************************************/
+
+#ifndef GATTSERVAPP_H
+#define GATTSERVAPP_H
+
+#include "bcomdef.h"
+#include "gatt.h"
+
+#define GATT_ALL_SERVICES                0xFFFFFFFF
+
+#define GATT_CLIENT_CFG_NOTIFY           0x0001
+#define GATT_CLIENT_CFG_INDICATE         0x0002
+
+#define GATT_CFG_NO_OPERATION            0x0000
+
+#define INVALID_CONNHANDLE               0xFFFF
+#define LOOPBACK_CONNHANDLE              0xFFFE
+
+typedef struct
+{
+  uint16 connHandle;
+  uint8  value;
+} gattCharCfg_t;
+
+typedef bStatus_t (*pfnGATTReadAttrCB_t)( uint16 connHandle, gattAttribute_t *pAttr,
+                                          uint8 *pValue, uint8 *pLen, uint16 offset,
+                                          uint8 maxLen );
+typedef bStatus_t (*pfnGATTWriteAttrCB_t)( uint16 connHandle, gattAttribute_t *pAttr,
+                                           uint8 *pValue, uint8 len, uint16 offset );
+typedef bStatus_t (*pfnGATTAuthorizeAttrCB_t)( uint16 connHandle, gattAttribute_t *pAttr,
+                                               uint8 opcode );
+
+typedef struct
+{
+  pfnGATTReadAttrCB_t pfnReadAttrCB;
+  pfnGATTWriteAttrCB_t pfnWriteAttrCB;
+  pfnGATTAuthorizeAttrCB_t pfnAuthorizeAttrCB;
+} gattServiceCBs_t;
+
+
+extern bStatus_t GATTServApp_RegisterService( gattAttribute_t *pAttrs, uint16 numAttrs,
+                                              CONST gattServiceCBs_t *pServiceCBs );
+extern bStatus_t GATTServApp_AddService( uint32 services );
+extern void GATTServApp_InitCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl );
+extern uint16 GATTServApp_ReadCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl );
+extern bStatus_t GATTServApp_ProcessCCCWriteReq( uint16 connHandle, gattAttribute_t *pAttr,
+                                                 uint8 *pValue, uint8 len, uint16 offset,
+                                                 uint16 validCfg );
+extern bStatus_t GATTServApp_ProcessCharCfg( gattCharCfg_t *charCfgTbl, uint8 *pValue,
+                                             uint8 authenticated, gattAttribute_t *attrTbl,
+                                             uint16 numAttrs, uint8 taskId );
+
+#endif
@@ -0,0 +1,15 @@
+/**************************************************************************************************
+  Filename:       hal_adc.h
+
+  Description:    Host simulation stand-in for the HAL ADC driver.
+
+**************************************************************************************************/
+
+#ifndef HAL_ADC_H
+#define HAL_ADC_H
+
+#include "hal_types.h"
+
+extern void HalAdcInit( void );
+
+#endif
@@ -0,0 +1,13 @@
+/**************************************************************************************************
+  Filename:       hal_key.h
+
+  Description:    Host simulation stand-in for the HAL key driver.
+
+**************************************************************************************************/
+
+#ifndef HAL_KEY_H
+#define HAL_KEY_H
+
+#include "hal_types.h"
+
+#endif
@@ -0,0 +1,18 @@
+/**************************************************************************************************
+  Filename:       hal_lcd.h
+
+  Description:    Host simulation stand-in for the HAL LCD driver. The simulation builds
+                  with HAL_LCD=FALSE, as the release configuration does.
+
+**************************************************************************************************/
+
+#ifndef HAL_LCD_H
+#define HAL_LCD_H
+
+#include "hal_types.h"
+
+#define HAL_LCD_LINE_1      0x01
+#define HAL_LCD_LINE_2      0x02
+#define HAL_LCD_LINE_3      0x03
+
+#endif
@@ -0,0 +1,13 @@
+/**************************************************************************************************
+  Filename:       hal_led.h
+
+  Description:    Host simulation stand-in for the HAL LED driver (unused by RoboRoach).
+
+**************************************************************************************************/
+
+#ifndef HAL_LED_H
+#define HAL_LED_H
+
+#include "hal_types.h"
+
+#endif
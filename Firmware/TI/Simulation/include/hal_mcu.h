@@ -0,0 +1,42 @@
+/**************************************************************************************************
+  Filename:       hal_mcu.h
+
+  Description:    Host simulation stand-in for the CC254x MCU abstraction: critical
+                  sections and interrupt service routine declarations.
+
+**************************************************************************************************/
+
+#ifndef _HAL_MCU_H
+#define _HAL_MCU_H
+
+#include "hal_types.h"
+#include "ioCC2540.h"
+
+typedef uint8 halIntState_t;
+
+#define HAL_ENABLE_INTERRUPTS()         st( EA = 1; )
+#define HAL_DISABLE_INTERRUPTS()        st( EA = 0; )
+#define HAL_INTERRUPTS_ARE_ENABLED()    (EA)
+
+#define HAL_ENTER_CRITICAL_SECTION(x)   st( x = EA;  EA = 0; )
+#define HAL_EXIT_CRITICAL_SECTION(x)    st( EA = x; )
+#define HAL_CRITICAL_STATEMENT(x)       st( halIntState_t _s; HAL_ENTER_CRITICAL_SECTION(_s); x; HAL_EXIT_CRITICAL_SECTION(_s); )
+
+#ifndef st
+  #define st(x)      do { x } while (__LINE__ == -1)
+#endif
+
+/* Interrupt service routines are registered with the simulated vector table
+ * before main() runs, so the simulator can raise them by vector number. */
+extern void simRegisterIsr( uint8 vector, void (*isr)( void ) );
+
+#define HAL_ISR_FUNC_DECLARATION(f,v) \
+  void f( void ); \
+  static void __attribute__((constructor)) f##_simRegister( void ) { simRegisterIsr( (v), f ); } \
+  void f( void )
+#define HAL_ISR_FUNC_PROTOTYPE(f,v)     void f( void )
+#define HAL_ISR_FUNCTION(f,v)           HAL_ISR_FUNC_DECLARATION(f,v)
+
+#define HAL_MCU_CC2541
+
+#endif
@@ -0,0 +1,15 @@
+/**************************************************************************************************
+  Filename:       hal_sleep.h
+
+  Description:    Host simulation stand-in for the HAL sleep driver.
+
+**************************************************************************************************/
+
+#ifndef HAL_SLEEP_H
+#define HAL_SLEEP_H
+
+#include "hal_types.h"
+
+extern void halSleep( uint32 osal_timer );
+
+#endif
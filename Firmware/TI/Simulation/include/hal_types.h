@@ -0,0 +1,37 @@
+/**************************************************************************************************
+  Filename:       hal_types.h
+
+  Description:    Host simulation stand-in for the CC254x HAL type definitions.
+
+**************************************************************************************************/
+
+#ifndef _HAL_TYPES_H
+#define _HAL_TYPES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int8_t    int8;
+typedef uint8_t   uint8;
+typedef int16_t   int16;
+typedef uint16_t  uint16;
+typedef int32_t   int32;
+typedef uint32_t  uint32;
+
+typedef uint8     bool;
+typedef uint8     halDataAlign_t;
+
+#ifndef TRUE
+  #define TRUE  1
+#endif
+#ifndef FALSE
+  #define FALSE 0
+#endif
+#ifndef NULL
+  #define NULL  0
+#endif
+
+#define CODE
+#define XDATA
+
+#endif
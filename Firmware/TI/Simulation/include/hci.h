@@ -0,0 +1,18 @@
+/**************************************************************************************************
+  Filename:       hci.h
+
+  Description:    Host simulation stand-in for the vendor-specific HCI extensions.
+
+**************************************************************************************************/
+
+#ifndef HCI_H
+#define HCI_H
+
+#include "bcomdef.h"
+
+#define HCI_EXT_DISABLE_CLK_DIVIDE_ON_HALT   0
+#define HCI_EXT_ENABLE_CLK_DIVIDE_ON_HALT    1
+
+extern uint8 HCI_EXT_ClkDivOnHaltCmd( uint8 control );
+
+#endif
@@ -0,0 +1,156 @@
+/**************************************************************************************************
+  Filename:       ioCC2540.h
+
+  Description:    Host simulation stand-in for the IAR CC254x special function register
+                  header. Every SFR the RoboRoach sources touch is a plain byte owned by
+                  the simulator; bit-addressable SFRs overlay their bits so code like
+                  "P1_0 = 1" compiles unchanged. USART0 data/status go through accessors
+                  so the simulator sees each SPI byte as it is shifted out.
+
+**************************************************************************************************/
+
+#ifndef IOCC2540_H
+#define IOCC2540_H
+
+#include <stdint.h>
+
+typedef union
+{
+  uint8_t byte;
+  struct
+  {
+    uint8_t b0 : 1;
+    uint8_t b1 : 1;
+    uint8_t b2 : 1;
+    uint8_t b3 : 1;
+    uint8_t b4 : 1;
+    uint8_t b5 : 1;
+    uint8_t b6 : 1;
+    uint8_t b7 : 1;
+  } bit;
+} simSfr_t;
+
+/* Interrupt vectors (IAR numbering) */
+#define RFERR_VECTOR    0
+#define ADC_VECTOR      1
+#define URX0_VECTOR     2
+#define URX1_VECTOR     3
+#define ENC_VECTOR      4
+#define ST_VECTOR       5
+#define P2INT_VECTOR    6
+#define UTX0_VECTOR     7
+#define DMA_VECTOR      8
+#define T1_VECTOR       9
+#define T2_VECTOR       10
+#define T3_VECTOR       11
+#define T4_VECTOR       12
+#define P0INT_VECTOR    13
+#define UTX1_VECTOR     14
+#define P1INT_VECTOR    15
+#define RF_VECTOR       16
+#define WDT_VECTOR      17
+#define SIM_NUM_VECTORS 18
+
+/* Bit-addressable SFRs */
+extern volatile simSfr_t simP0, simP1, simP2;
+extern volatile simSfr_t simIEN0, simIEN1, simIEN2;
+extern volatile simSfr_t simTCON, simIRCON, simIRCON2, simS0CON, simS1CON;
+
+#define P0        simP0.byte
+#define P1        simP1.byte
+#define P2        simP2.byte
+
+#define P0_0      simP0.bit.b0
+#define P0_1      simP0.bit.b1
+#define P0_2      simP0.bit.b2
+#define P0_3      simP0.bit.b3
+#define P0_4      simP0.bit.b4
+#define P0_5      simP0.bit.b5
+#define P0_6      simP0.bit.b6
+#define P0_7      simP0.bit.b7
+
+#define P1_0      simP1.bit.b0
+#define P1_1      simP1.bit.b1
+#define P1_2      simP1.bit.b2
+#define P1_3      simP1.bit.b3
+#define P1_4      simP1.bit.b4
+#define P1_5      simP1.bit.b5
+#define P1_6      simP1.bit.b6
+#define P1_7      simP1.bit.b7
+
+#define P2_0      simP2.bit.b0
+#define P2_1      simP2.bit.b1
+#define P2_2      simP2.bit.b2
+#define P2_3      simP2.bit.b3
+#define P2_4      simP2.bit.b4
+
+#define IEN0      simIEN0.byte
+#define EA        simIEN0.bit.b7
+#define STIE      simIEN0.bit.b5
+#define ENCIE     simIEN0.bit.b4
+#define URX1IE    simIEN0.bit.b3
+#define URX0IE    simIEN0.bit.b2
+#define ADCIE     simIEN0.bit.b1
+#define RFERRIE   simIEN0.bit.b0
+
+#define IEN1      simIEN1.byte
+#define P0IE      simIEN1.bit.b5
+#define T4IE      simIEN1.bit.b4
+#define T3IE      simIEN1.bit.b3
+#define T2IE      simIEN1.bit.b2
+#define T1IE      simIEN1.bit.b1
+#define DMAIE     simIEN1.bit.b0
+
+#define IEN2      simIEN2.byte
+#define UTX0IE_BV 0x04
+
+#define TCON      simTCON.byte
+#define URX1IF    simTCON.bit.b7
+#define ADCIF     simTCON.bit.b5
+#define URX0IF    simTCON.bit.b3
+
+#define IRCON     simIRCON.byte
+#define STIF      simIRCON.bit.b7
+#define P0IF      simIRCON.bit.b5
+#define T4IF      simIRCON.bit.b4
+#define T3IF      simIRCON.bit.b3
+#define T2IF      simIRCON.bit.b2
+#define T1IF      simIRCON.bit.b1
+#define DMAIF     simIRCON.bit.b0
+
+#define IRCON2    simIRCON2.byte
+#define WDTIF     simIRCON2.bit.b4
+#define P1IF      simIRCON2.bit.b3
+#define UTX1IF    simIRCON2.bit.b2
+#define UTX0IF    simIRCON2.bit.b1
+#define P2IF      simIRCON2.bit.b0
+
+/* Byte SFRs */
+extern volatile uint8_t P0SEL, P1SEL, P2SEL, P0DIR, P1DIR, P2DIR, PERCFG, APCFG;
+extern volatile uint8_t CLKCONCMD, CLKCONSTA, SLEEPCMD, SLEEPSTA, PCON;
+extern volatile uint8_t U0GCR, U0BAUD, U0UCR;
+extern volatile uint8_t T1CTL, T1STAT, T1CNTH;
+extern volatile uint8_t T1CC0L, T1CC0H, T1CC1L, T1CC1H, T1CC2L, T1CC2H, T1CC3L, T1CC3H, T1CC4L, T1CC4H;
+extern volatile uint8_t T1CCTL0, T1CCTL1, T1CCTL2, T1CCTL3, T1CCTL4, TIMIF;
+extern volatile uint8_t T4CTL, T4CNT, T4CCTL0, T4CC0, T4CCTL1, T4CC1;
+extern volatile uint8_t ST1, ST2;
+
+/* USART0: every access goes through the simulator so SPI bytes are seen in order */
+extern volatile uint8_t *simU0CSR( void );
+extern volatile uint8_t *simU0DBUF( void );
+#define U0CSR     (*simU0CSR())
+#define U0DBUF    (*simU0DBUF())
+
+/* Timer 1: any write to T1CNTL clears the counter */
+extern volatile uint8_t *simT1CNTL( void );
+#define T1CNTL    (*simT1CNTL())
+
+/* Sleep timer: reading ST0 latches ST1/ST2 on the real part */
+extern volatile uint8_t *simST0( void );
+#define ST0       (*simST0())
+
+/* A NOP takes one cycle, during which the simulated hardware runs */
+extern void simNop( void );
+#define asm(x)    simNop()
+
+#endif
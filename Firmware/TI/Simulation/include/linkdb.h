@@ -0,0 +1,27 @@
+/**************************************************************************************************
+  Filename:       linkdb.h
+
+  Description:    Host simulation stand-in for the link database.
+
+**************************************************************************************************/
+
+#ifndef LINKDB_H
+#define LINKDB_H
+
+#include "bcomdef.h"
+
+#define LINKDB_STATUS_UPDATE_NEW         0
+#define LINKDB_STATUS_UPDATE_REMOVED     1
+#define LINKDB_STATUS_UPDATE_STATEFLAGS  2
+
+#define LINK_NOT_CONNECTED               0x00
+#define LINK_CONNECTED                   0x01
+
+typedef void (*pfnLinkDBCB_t)( uint16 connectionHandle, uint8 changeType );
+
+extern uint8 linkDB_Register( pfnLinkDBCB_t pFunc );
+extern uint8 linkDB_State( uint16 connectionHandle, uint8 state );
+
+#define linkDB_Up( connectionHandle )  linkDB_State( (connectionHandle), LINK_CONNECTED )
+
+#endif
@@ -0,0 +1 @@
+#include "OSAL.h"
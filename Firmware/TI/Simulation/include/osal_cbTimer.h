@@ -0,0 +1,19 @@
+/**************************************************************************************************
+  Filename:       osal_cbTimer.h
+
+  Description:    Host simulation stand-in for the OSAL callback timers.
+
+**************************************************************************************************/
+
+#ifndef OSAL_CBTIMER_H
+#define OSAL_CBTIMER_H
+
+#include "comdef.h"
+
+typedef void (*pfnCbTimer_t)( uint8 *pData );
+
+extern Status_t osal_CbTimerStart( pfnCbTimer_t pfnCbTimer, uint8 *pData,
+                                   uint32 timeout, uint8 *pTimerId );
+extern Status_t osal_CbTimerStop( uint8 timerId );
+
+#endif
@@ -0,0 +1,21 @@
+/**************************************************************************************************
+  Filename:       osal_snv.h
+
+  Description:    Host simulation stand-in for the simple non-volatile memory driver.
+
+**************************************************************************************************/
+
+#ifndef OSAL_SNV_H
+#define OSAL_SNV_H
+
+#include "hal_types.h"
+
+typedef uint8 osalSnvId_t;
+typedef uint8 osalSnvLen_t;
+
+extern uint8 osal_snv_init( void );
+extern uint8 osal_snv_read( osalSnvId_t id, osalSnvLen_t len, void *pBuf );
+extern uint8 osal_snv_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf );
+extern uint8 osal_snv_compact( uint8 threshold );
+
+#endif
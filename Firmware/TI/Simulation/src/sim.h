@@ -0,0 +1,108 @@
+/**************************************************************************************************
+  Filename:       sim.h
+
+  Description:    Internal interface of the RoboRoach host simulation: the virtual
+                  clock, the hardware models and the fake BLE stack.
+
+                  Time is counted in 32 MHz system clock cycles so Timer 1 can be
+                  stepped at any prescaler. Firmware code runs in zero virtual time
+                  except where a model charges it (SPI bytes shifted out while the
+                  CPU busy-waits).
+
+**************************************************************************************************/
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include "hal_types.h"
+
+#define SIM_CYCLES_PER_US         32ULL
+#define SIM_US(us)                ( (uint64_t)(us) * SIM_CYCLES_PER_US )
+#define SIM_MS(ms)                ( (uint64_t)(ms) * 1000ULL * SIM_CYCLES_PER_US )
+
+// The GAP role runs as task 0, ahead of the application task; the firmware
+// sleep handler used to assume the app is task 11
+#define SIM_BLE_TASK_ID           0x00
+#define SIM_APP_TASK_ID           0x0B
+#define SIM_NUM_TASKS             ( SIM_APP_TASK_ID + 1 )
+
+/*********************************************************************
+ * Virtual clock and scheduler (sim_osal.c)
+ */
+extern uint64_t simNow( void );
+extern uint64_t simNowUs( void );
+extern void     simCharge( uint64_t cycles );
+extern uint64_t simNowCharged( void );
+extern void     simRunUntil( uint64_t cycles );
+extern void     simRunTasks( void );
+extern void     simOsalInit( void );
+extern uint8    simPwrmgrHeld( void );
+extern uint16   simPendingEvents( uint8 taskId );
+extern uint32   simActiveTimers( uint8 taskId );
+extern uint32   simSnvWrites( void );
+
+/*********************************************************************
+ * Hardware models (sim_hw.c)
+ */
+extern void     simHwInit( void );
+extern void     simHwAdvance( uint64_t from, uint64_t to );
+extern uint64_t simHwNextEvent( uint64_t now );
+extern void     simHwSample( void );
+extern uint8    simWiper( uint8 n );
+extern uint32   simSpiBytes( void );
+extern uint32   simSpiCutBytes( void );
+extern uint8    simClkDivOnHalt( void );
+extern void     simSetClkDivOnHalt( uint8 enabled );
+
+// Signal trace: called whenever an observed pin or wiper changes
+typedef void (*simTraceCB_t)( uint64_t cycles, uint8 signal, uint32 value );
+extern void     simSetTrace( simTraceCB_t pfnTrace );
+
+// Observed signals
+enum
+{
+  SIM_SIG_ANTENNA_LEFT = 0,
+  SIM_SIG_ANTENNA_RIGHT,
+  SIM_SIG_LED_LEFT,
+  SIM_SIG_LED_RIGHT,
+  SIM_SIG_LED_CONNECTION_1,
+  SIM_SIG_LED_CONNECTION_2,
+  SIM_SIG_WIPER_0,
+  SIM_SIG_WIPER_1,
+  SIM_NUM_SIGNALS
+};
+extern const char *simSignalName( uint8 signal );
+extern uint32   simSignalValue( uint8 signal );
+extern uint8    simSignalWidth( uint8 signal );
+
+/*********************************************************************
+ * Waveform capture (sim_vcd.c)
+ */
+extern uint8    simVcdOpen( const char *path );
+extern void     simVcdTrace( uint64_t cycles, uint8 signal, uint32 value );
+extern void     simVcdClose( void );
+
+/*********************************************************************
+ * Fake BLE stack (sim_ble.c)
+ */
+extern uint16   simBleProcessEvent( uint8 task_id, uint16 events );
+extern void     simBleStart( void );
+extern void     simBleConnect( void );
+extern void     simBleDisconnect( void );
+extern void     simBleTimeout( void );
+extern void     simBleConnectOnRestart( void );
+extern void     simBleReportDelay( uint16 ms );
+extern uint8    simBleConnected( void );
+extern uint8    simGattWrite( uint16 uuid, uint8 *pValue, uint8 len, uint8 withResponse );
+extern uint8    simGattRead( uint16 uuid, uint8 *pValue, uint8 *pLen );
+extern uint8    simGattEnableNotify( uint16 uuid );
+extern void     simBleDump( void );
+extern uint8    simAdvertData( uint8 *pData );
+extern void     simSetBatteryLevel( uint8 level );
+extern uint16   simAdvertInterval( void );
+
+typedef void (*simNotifyCB_t)( uint16 uuid, uint8 *pValue, uint8 len );
+extern void     simSetNotifyCB( simNotifyCB_t pfnNotify );
+
+#endif /* SIM_H */
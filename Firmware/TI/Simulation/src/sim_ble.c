@@ -0,0 +1,817 @@
+/**************************************************************************************************
+  Filename:       sim_ble.c
+
+  Description:    Fake BLE stack for the RoboRoach host simulation: the GAP
+                  peripheral role state machine, the GATT server attribute
+                  database with read/write/notify through the registered
+                  service callbacks, the link database, and no-op stand-ins
+                  for the services the application adds.
+
+                  Role state changes are reported from the stack task
+                  (SIM_BLE_TASK_ID), after the application task returns, as
+                  the GAP role task does on the CC254x.
+
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "hci.h"
+#include "gap.h"
+#include "gatt.h"
+#include "gatt_uuid.h"
+#include "gattservapp.h"
+#include "gapgattserver.h"
+#include "gapbondmgr.h"
+#include "linkdb.h"
+#include "peripheral.h"
+#include "battservice.h"
+#include "devinfoservice.h"
+#include "hal_adc.h"
+#include "hal_sleep.h"
+
+#include "sim.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define SIM_MAX_SERVICES          4
+#define SIM_FIRST_HANDLE          0x0001
+#define SIM_CONN_HANDLE           0x0000
+#define SIM_ATT_MTU               23
+#define SIM_GAP_PARAMS            16
+
+// Stack task events
+#define SIM_BLE_STATE_EVT         0x0001
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  gattAttribute_t           *pAttrs;
+  uint16                     numAttrs;
+  CONST gattServiceCBs_t    *pCBs;
+} simService_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+CONST uint8 primaryServiceUUID[ATT_BT_UUID_SIZE] =
+  { LO_UINT16( GATT_PRIMARY_SERVICE_UUID ), HI_UINT16( GATT_PRIMARY_SERVICE_UUID ) };
+CONST uint8 characterUUID[ATT_BT_UUID_SIZE] =
+  { LO_UINT16( GATT_CHARACTER_UUID ), HI_UINT16( GATT_CHARACTER_UUID ) };
+CONST uint8 charUserDescUUID[ATT_BT_UUID_SIZE] =
+  { LO_UINT16( GATT_CHAR_USER_DESC_UUID ), HI_UINT16( GATT_CHAR_USER_DESC_UUID ) };
+CONST uint8 clientCharCfgUUID[ATT_BT_UUID_SIZE] =
+  { LO_UINT16( GATT_CLIENT_CHAR_CFG_UUID ), HI_UINT16( GATT_CLIENT_CHAR_CFG_UUID ) };
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static simService_t     simServices[SIM_MAX_SERVICES];
+static uint8            simNumServices = 0;
+static uint16           simNextHandle = SIM_FIRST_HANDLE;
+
+static gapRolesCBs_t   *simRoleCBs = NULL;
+static gaprole_States_t simRoleState = GAPROLE_INIT;
+static gaprole_States_t simRoleQueue[8];
+static uint8            simRoleQueued = 0;
+static uint8            simAdvEnabled = TRUE;
+static uint8            simConnected = FALSE;
+static uint8            simConnectOnRestart = FALSE;
+static uint16           simReportDelay = 0;     // ms before a state change is reported
+
+static uint16           simMinInterval, simMaxInterval, simLatency, simTimeout;
+static uint16           simConnInterval = 80;
+static uint16           simConnLatency = 0;
+static uint16           simConnTimeout = 1000;
+static uint16           simGapParams[SIM_GAP_PARAMS];
+static uint8            simAdvData[31];
+static uint8            simAdvLen = 0;
+static uint8            simBattLevel = 100;
+static uint16           simAdvInterval = 0;
+
+static pfnLinkDBCB_t    simLinkCB = NULL;
+static simNotifyCB_t    simNotify = NULL;
+
+static CONST uint8      simBdAddr[B_ADDR_LEN] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 };
+
+/*********************************************************************
+ * GAP peripheral role
+ */
+
+static void simBleLinkUp( void );
+
+// Queue a state change for the stack task to report
+static void simRoleSetState( gaprole_States_t newState )
+{
+  if ( simRoleQueued < sizeof( simRoleQueue ) )
+  {
+    simRoleQueue[simRoleQueued++] = newState;
+  }
+  if ( simReportDelay )
+  {
+    osal_start_timerEx( SIM_BLE_TASK_ID, SIM_BLE_STATE_EVT, simReportDelay );
+  }
+  else
+  {
+    osal_set_event( SIM_BLE_TASK_ID, SIM_BLE_STATE_EVT );
+  }
+}
+
+uint16 simBleProcessEvent( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+
+  if ( events & SIM_BLE_STATE_EVT )
+  {
+    uint8 i;
+
+    for ( i = 0; i < simRoleQueued; i++ )
+    {
+      if ( simConnectOnRestart && ( simRoleQueue[i] == GAPROLE_ADVERTISING ) &&
+           ( simRoleState == GAPROLE_WAITING ) )
+      {
+        // The connect request came on the first advertising event: the
+        // application hears of the link, not of the advertising
+        simConnectOnRestart = FALSE;
+        simBleLinkUp();
+        simRoleQueue[i] = GAPROLE_CONNECTED;
+      }
+      simRoleState = simRoleQueue[i];
+      printf( "%10llu us  gap: state %d\n", (unsigned long long)simNowUs(), simRoleState );
+      if ( simRoleState == GAPROLE_ADVERTISING )
+      {
+        // Like the stack, take the interval when advertising starts
+        simAdvInterval = simGapParams[TGAP_GEN_DISC_ADV_INT_MIN];
+        printf( "%10llu us  gap: advertising every %u us\n", (unsigned long long)simNowUs(),
+                simAdvInterval * 625u );
+      }
+      if ( simRoleCBs && simRoleCBs->pfnStateChange )
+      {
+        simRoleCBs->pfnStateChange( simRoleState );
+      }
+    }
+    simRoleQueued = 0;
+  }
+  return 0;
+}
+
+bStatus_t GAPRole_StartDevice( gapRolesCBs_t *pAppCallbacks )
+{
+  if ( simRoleCBs != NULL )
+  {
+    return ( bleAlreadyInRequestedMode );
+  }
+  simRoleCBs = pAppCallbacks;
+  simRoleSetState( GAPROLE_STARTED );
+  if ( simAdvEnabled )
+  {
+    simRoleSetState( GAPROLE_ADVERTISING );
+  }
+  return ( SUCCESS );
+}
+
+bStatus_t GAPRole_SetParameter( uint16 param, uint8 len, void *pValue )
+{
+  uint16 value = ( len >= 2 ) ? *(uint16 *)pValue : ( len == 1 ) ? *(uint8 *)pValue : 0;
+
+  switch ( param )
+  {
+    case GAPROLE_ADVERT_ENABLED:
+      if ( simAdvEnabled != (uint8)value )
+      {
+        simAdvEnabled = (uint8)value;
+        if ( simRoleCBs && !simConnected )
+        {
+          simRoleSetState( simAdvEnabled ? GAPROLE_ADVERTISING : GAPROLE_WAITING );
+        }
+      }
+      break;
+
+    case GAPROLE_ADVERT_DATA:
+      if ( len > sizeof( simAdvData ) )
+      {
+        return ( bleInvalidRange );
+      }
+      memcpy( simAdvData, pValue, len );
+      simAdvLen = len;
+      break;
+
+    case GAPROLE_MIN_CONN_INTERVAL:   simMinInterval = value; break;
+    case GAPROLE_MAX_CONN_INTERVAL:   simMaxInterval = value; break;
+    case GAPROLE_SLAVE_LATENCY:       simLatency = value;     break;
+    case GAPROLE_TIMEOUT_MULTIPLIER:  simTimeout = value;     break;
+
+    case GAPROLE_PARAM_UPDATE_REQ:
+      if ( !simConnected )
+      {
+        return ( bleNotConnected );
+      }
+      // The central accepts the slowest interval of the requested range
+      simConnInterval = simMaxInterval;
+      simConnLatency = simLatency;
+      simConnTimeout = simTimeout;
+      printf( "%10llu us  gap: conn params %u-%u x1.25ms latency %u timeout %u\n",
+              (unsigned long long)simNowUs(), simMinInterval, simMaxInterval,
+              simLatency, simTimeout );
+      break;
+
+    default:
+      break;
+  }
+  return ( SUCCESS );
+}
+
+bStatus_t GAPRole_GetParameter( uint16 param, void *pValue )
+{
+  switch ( param )
+  {
+    case GAPROLE_ADVERT_ENABLED:      *(uint8 *)pValue = simAdvEnabled;       break;
+    case GAPROLE_STATE:               *(uint8 *)pValue = simRoleState;        break;
+    case GAPROLE_BD_ADDR:             memcpy( pValue, simBdAddr, B_ADDR_LEN ); break;
+    case GAPROLE_CONNHANDLE:          *(uint16 *)pValue = SIM_CONN_HANDLE;    break;
+    case GAPROLE_MIN_CONN_INTERVAL:   *(uint16 *)pValue = simMinInterval;     break;
+    case GAPROLE_MAX_CONN_INTERVAL:   *(uint16 *)pValue = simMaxInterval;     break;
+    case GAPROLE_SLAVE_LATENCY:       *(uint16 *)pValue = simLatency;         break;
+    case GAPROLE_TIMEOUT_MULTIPLIER:  *(uint16 *)pValue = simTimeout;         break;
+    case GAPROLE_CONN_INTERVAL:       *(uint16 *)pValue = simConnInterval;    break;
+    case GAPROLE_CONN_LATENCY:        *(uint16 *)pValue = simConnLatency;     break;
+    case GAPROLE_CONN_TIMEOUT:        *(uint16 *)pValue = simConnTimeout;     break;
+    default:
+      return ( INVALIDPARAMETER );
+  }
+  return ( SUCCESS );
+}
+
+// Drop the link; the new states are reported when the stack task runs.
+// newState is GAPROLE_WAITING, or GAPROLE_WAITING_AFTER_TIMEOUT when the
+// supervision timeout ended it.
+static void simBleLinkLost( gaprole_States_t newState )
+{
+  simConnected = FALSE;
+  if ( simLinkCB )
+  {
+    simLinkCB( SIM_CONN_HANDLE, LINKDB_STATUS_UPDATE_REMOVED );
+  }
+  simRoleSetState( newState );
+  if ( simAdvEnabled )
+  {
+    simRoleSetState( GAPROLE_ADVERTISING );
+  }
+}
+
+bStatus_t GAPRole_TerminateConnection( void )
+{
+  if ( !simConnected )
+  {
+    return ( bleIncorrectMode );
+  }
+  simBleLinkLost( GAPROLE_WAITING );
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * Central actions, driven by the scenario
+ */
+
+void simBleStart( void )
+{
+  simRunTasks();
+}
+
+static void simBleLinkUp( void )
+{
+  simConnected = TRUE;
+  simConnInterval = 80;
+  if ( simLinkCB )
+  {
+    simLinkCB( SIM_CONN_HANDLE, LINKDB_STATUS_UPDATE_NEW );
+  }
+}
+
+void simBleConnect( void )
+{
+  if ( simConnected || !simAdvEnabled )
+  {
+    printf( "%10llu us  gap: connect refused (not advertising)\n",
+            (unsigned long long)simNowUs() );
+    return;
+  }
+  simBleLinkUp();
+  simRoleSetState( GAPROLE_CONNECTED );
+  simRunTasks();
+}
+
+uint8 simBleConnected( void )
+{
+  return ( simConnected );
+}
+
+// The central connects as soon as advertising is started again, before the
+// stack reports it (restart for a new interval, or after a lost link)
+void simBleConnectOnRestart( void )
+{
+  simConnectOnRestart = TRUE;
+}
+
+// The stack reports state changes this many ms late (0 = at once), so an
+// advertising restart takes a while to finish
+void simBleReportDelay( uint16 ms )
+{
+  simReportDelay = ms;
+}
+
+void simBleDisconnect( void )
+{
+  if ( !simConnected )
+  {
+    return;
+  }
+  simBleLinkLost( GAPROLE_WAITING );
+  simRunTasks();
+}
+
+// The central goes out of range: the supervision timeout drops the link
+void simBleTimeout( void )
+{
+  if ( !simConnected )
+  {
+    return;
+  }
+  simBleLinkLost( GAPROLE_WAITING_AFTER_TIMEOUT );
+  simRunTasks();
+}
+
+/*********************************************************************
+ * GATT server
+ */
+
+static uint16 simAttrUuid( gattAttribute_t *pAttr )
+{
+  if ( pAttr->type.len != ATT_BT_UUID_SIZE )
+  {
+    return 0;
+  }
+  return BUILD_UINT16( pAttr->type.uuid[0], pAttr->type.uuid[1] );
+}
+
+// Characteristic value attribute with this UUID
+static gattAttribute_t *simFindAttr( uint16 uuid, simService_t **ppService )
+{
+  uint8 s;
+  uint16 i;
+
+  for ( s = 0; s < simNumServices; s++ )
+  {
+    for ( i = 0; i < simServices[s].numAttrs; i++ )
+    {
+      if ( simAttrUuid( &simServices[s].pAttrs[i] ) == uuid )
+      {
+        *ppService = &simServices[s];
+        return &simServices[s].pAttrs[i];
+      }
+    }
+  }
+  return NULL;
+}
+
+static gattAttribute_t *simFindHandle( uint16 handle, simService_t **ppService )
+{
+  uint8 s;
+
+  for ( s = 0; s < simNumServices; s++ )
+  {
+    uint16 first = simServices[s].pAttrs[0].handle;
+
+    if ( ( handle >= first ) && ( handle < first + simServices[s].numAttrs ) )
+    {
+      *ppService = &simServices[s];
+      return &simServices[s].pAttrs[handle - first];
+    }
+  }
+  return NULL;
+}
+
+bStatus_t GATTServApp_RegisterService( gattAttribute_t *pAttrs, uint16 numAttrs,
+                                       CONST gattServiceCBs_t *pServiceCBs )
+{
+  uint16 i;
+
+  if ( simNumServices == SIM_MAX_SERVICES )
+  {
+    return ( bleNoResources );
+  }
+  for ( i = 0; i < numAttrs; i++ )
+  {
+    pAttrs[i].handle = simNextHandle++;
+  }
+  simServices[simNumServices].pAttrs = pAttrs;
+  simServices[simNumServices].numAttrs = numAttrs;
+  simServices[simNumServices].pCBs = pServiceCBs;
+  simNumServices++;
+  return ( SUCCESS );
+}
+
+bStatus_t GATTServApp_AddService( uint32 services )
+{
+  (void)services;
+  return ( SUCCESS );
+}
+
+void GATTServApp_InitCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl )
+{
+  uint8 i;
+
+  for ( i = 0; i < GATT_MAX_NUM_CONN; i++ )
+  {
+    if ( ( connHandle == INVALID_CONNHANDLE ) || ( charCfgTbl[i].connHandle == connHandle ) )
+    {
+      charCfgTbl[i].connHandle = INVALID_CONNHANDLE;
+      charCfgTbl[i].value = GATT_CFG_NO_OPERATION;
+    }
+  }
+}
+
+uint16 GATTServApp_ReadCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl )
+{
+  uint8 i;
+
+  for ( i = 0; i < GATT_MAX_NUM_CONN; i++ )
+  {
+    if ( charCfgTbl[i].connHandle == connHandle )
+    {
+      return charCfgTbl[i].value;
+    }
+  }
+  return ( GATT_CFG_NO_OPERATION );
+}
+
+bStatus_t GATTServApp_ProcessCCCWriteReq( uint16 connHandle, gattAttribute_t *pAttr,
+                                          uint8 *pValue, uint8 len, uint16 offset,
+                                          uint16 validCfg )
+{
+  gattCharCfg_t *pTbl = (gattCharCfg_t *)pAttr->pValue;
+  uint16 value;
+  uint8 i;
+
+  if ( offset > 0 )
+  {
+    return ( ATT_ERR_ATTR_NOT_LONG );
+  }
+  if ( len != 2 )
+  {
+    return ( ATT_ERR_INVALID_VALUE_SIZE );
+  }
+  value = BUILD_UINT16( pValue[0], pValue[1] );
+  if ( ( value != GATT_CFG_NO_OPERATION ) && ( value != validCfg ) )
+  {
+    return ( ATT_ERR_INVALID_VALUE );
+  }
+
+  for ( i = 0; i < GATT_MAX_NUM_CONN; i++ )
+  {
+    if ( ( pTbl[i].connHandle == connHandle ) || ( pTbl[i].connHandle == INVALID_CONNHANDLE ) )
+    {
+      pTbl[i].connHandle = connHandle;
+      pTbl[i].value = (uint8)value;
+      return ( SUCCESS );
+    }
+  }
+  return ( ATT_ERR_INSUFFICIENT_RESOURCES );
+}
+
+bStatus_t GATTServApp_ProcessCharCfg( gattCharCfg_t *charCfgTbl, uint8 *pValue,
+                                      uint8 authenticated, gattAttribute_t *attrTbl,
+                                      uint16 numAttrs, uint8 taskId )
+{
+  uint16 i;
+  uint8 c;
+
+  (void)taskId;
+  for ( i = 0; i < numAttrs; i++ )
+  {
+    if ( attrTbl[i].pValue == pValue )
+    {
+      break;
+    }
+  }
+  if ( i == numAttrs )
+  {
+    return ( ATT_ERR_INVALID_HANDLE );
+  }
+
+  for ( c = 0; c < GATT_MAX_NUM_CONN; c++ )
+  {
+    if ( ( charCfgTbl[c].connHandle != INVALID_CONNHANDLE ) &&
+         ( charCfgTbl[c].value & GATT_CLIENT_CFG_NOTIFY ) )
+    {
+      simService_t *pService;
+      attHandleValueNoti_t noti;
+
+      if ( ( simFindHandle( attrTbl[i].handle, &pService ) == NULL ) ||
+           ( pService->pCBs->pfnReadAttrCB( charCfgTbl[c].connHandle, &attrTbl[i],
+                                            noti.value, &noti.len, 0,
+                                            SIM_ATT_MTU - 3 ) != SUCCESS ) )
+      {
+        continue;
+      }
+      noti.handle = attrTbl[i].handle;
+      VOID GATT_Notification( charCfgTbl[c].connHandle, &noti, authenticated );
+    }
+  }
+  return ( SUCCESS );
+}
+
+bStatus_t GATT_Notification( uint16 connHandle, attHandleValueNoti_t *pNoti, uint8 authenticated )
+{
+  simService_t *pService;
+  gattAttribute_t *pAttr = simFindHandle( pNoti->handle, &pService );
+
+  (void)authenticated;
+  if ( !simConnected || ( connHandle != SIM_CONN_HANDLE ) || ( pAttr == NULL ) )
+  {
+    return ( bleNotConnected );
+  }
+  if ( simNotify )
+  {
+    simNotify( simAttrUuid( pAttr ), pNoti->value, pNoti->len );
+  }
+  return ( SUCCESS );
+}
+
+uint8 simGattWrite( uint16 uuid, uint8 *pValue, uint8 len, uint8 withResponse )
+{
+  simService_t *pService;
+  gattAttribute_t *pAttr = simFindAttr( uuid, &pService );
+  uint8 status;
+
+  if ( !simConnected )
+  {
+    return ( bleNotConnected );
+  }
+  if ( pAttr == NULL )
+  {
+    return ( ATT_ERR_ATTR_NOT_FOUND );
+  }
+  if ( !( pAttr->permissions & GATT_PERMIT_WRITE ) )
+  {
+    status = ATT_ERR_WRITE_NOT_PERMITTED;
+  }
+  else
+  {
+    status = pService->pCBs->pfnWriteAttrCB( SIM_CONN_HANDLE, pAttr, pValue, len, 0 );
+  }
+  if ( withResponse || ( status != SUCCESS ) )
+  {
+    printf( "%10llu us  gatt: write 0x%04X len %u -> 0x%02X\n",
+            (unsigned long long)simNowUs(), uuid, len, status );
+  }
+  simRunTasks();
+  return status;
+}
+
+// Read a value with Read Blob requests until a short response, as a central
+// does for a value longer than the MTU. *pLen is the buffer size on entry.
+uint8 simGattRead( uint16 uuid, uint8 *pValue, uint8 *pLen )
+{
+  simService_t *pService;
+  gattAttribute_t *pAttr = simFindAttr( uuid, &pService );
+  uint16 offset = 0;
+  uint8 room = *pLen;
+  uint8 status = SUCCESS;
+
+  *pLen = 0;
+  if ( !simConnected )
+  {
+    return ( bleNotConnected );
+  }
+  if ( pAttr == NULL )
+  {
+    return ( ATT_ERR_ATTR_NOT_FOUND );
+  }
+  if ( !( pAttr->permissions & GATT_PERMIT_READ ) )
+  {
+    return ( ATT_ERR_READ_NOT_PERMITTED );
+  }
+
+  while ( offset < room )
+  {
+    uint8 maxLen = SIM_ATT_MTU - 1;
+    uint8 len = 0;
+
+    if ( maxLen > room - offset )
+    {
+      maxLen = (uint8)( room - offset );
+    }
+    status = pService->pCBs->pfnReadAttrCB( SIM_CONN_HANDLE, pAttr, pValue + offset,
+                                            &len, offset, maxLen );
+    if ( status != SUCCESS )
+    {
+      // A short attribute answers the first blob request with "not long"
+      if ( ( offset > 0 ) && ( status == ATT_ERR_ATTR_NOT_LONG ) )
+      {
+        status = SUCCESS;
+      }
+      break;
+    }
+    offset += len;
+    if ( len < maxLen )
+    {
+      break;
+    }
+  }
+  *pLen = (uint8)offset;
+  simRunTasks();
+  return status;
+}
+
+uint8 simGattEnableNotify( uint16 uuid )
+{
+  simService_t *pService;
+  gattAttribute_t *pAttr = simFindAttr( uuid, &pService );
+  uint8 cfg[2] = { LO_UINT16( GATT_CLIENT_CFG_NOTIFY ), HI_UINT16( GATT_CLIENT_CFG_NOTIFY ) };
+  uint16 i;
+
+  if ( !simConnected )
+  {
+    return ( bleNotConnected );
+  }
+  if ( pAttr == NULL )
+  {
+    return ( ATT_ERR_ATTR_NOT_FOUND );
+  }
+
+  // The descriptor follows the value, before the next declaration
+  for ( i = (uint16)( pAttr - pService->pAttrs ) + 1; i < pService->numAttrs; i++ )
+  {
+    uint16 type = simAttrUuid( &pService->pAttrs[i] );
+
+    if ( type == GATT_CHARACTER_UUID )
+    {
+      break;
+    }
+    if ( type == GATT_CLIENT_CHAR_CFG_UUID )
+    {
+      return pService->pCBs->pfnWriteAttrCB( SIM_CONN_HANDLE, &pService->pAttrs[i],
+                                             cfg, sizeof( cfg ), 0 );
+    }
+  }
+  return ( ATT_ERR_ATTR_NOT_FOUND );
+}
+
+void simSetNotifyCB( simNotifyCB_t pfnNotify )
+{
+  simNotify = pfnNotify;
+}
+
+void simBleDump( void )
+{
+  uint8 s;
+  uint16 i;
+
+  for ( s = 0; s < simNumServices; s++ )
+  {
+    for ( i = 0; i < simServices[s].numAttrs; i++ )
+    {
+      gattAttribute_t *pAttr = &simServices[s].pAttrs[i];
+
+      printf( "0x%04X  type 0x%04X  perm 0x%02X\n", pAttr->handle, simAttrUuid( pAttr ),
+              pAttr->permissions );
+    }
+  }
+}
+
+/*********************************************************************
+ * Link database
+ */
+
+uint8 linkDB_Register( pfnLinkDBCB_t pFunc )
+{
+  simLinkCB = pFunc;
+  return ( SUCCESS );
+}
+
+uint8 linkDB_State( uint16 connectionHandle, uint8 state )
+{
+  return ( connectionHandle == SIM_CONN_HANDLE ) && simConnected &&
+         ( ( state & LINK_CONNECTED ) != 0 );
+}
+
+/*********************************************************************
+ * GAP, bond manager, HCI extensions and the stock services
+ */
+
+bStatus_t GAP_SetParamValue( uint16 paramID, uint16 paramValue )
+{
+  if ( paramID >= SIM_GAP_PARAMS )
+  {
+    return ( INVALIDPARAMETER );
+  }
+  simGapParams[paramID] = paramValue;
+  return ( SUCCESS );
+}
+
+uint16 GAP_GetParamValue( uint16 paramID )
+{
+  return ( paramID < SIM_GAP_PARAMS ) ? simGapParams[paramID] : 0;
+}
+
+bStatus_t GAPBondMgr_SetParameter( uint16 param, uint8 len, void *pValue )
+{
+  (void)param; (void)len; (void)pValue;
+  return ( SUCCESS );
+}
+
+bStatus_t GAPBondMgr_Register( gapBondCBs_t *pCB )
+{
+  (void)pCB;
+  return ( SUCCESS );
+}
+
+bStatus_t GGS_SetParameter( uint8 param, uint8 len, void *value )
+{
+  (void)param; (void)len; (void)value;
+  return ( SUCCESS );
+}
+
+bStatus_t GGS_AddService( uint32 services )
+{
+  (void)services;
+  return ( SUCCESS );
+}
+
+bStatus_t DevInfo_AddService( void )
+{
+  return ( SUCCESS );
+}
+
+bStatus_t DevInfo_SetParameter( uint8 param, uint8 len, void *value )
+{
+  (void)param; (void)len; (void)value;
+  return ( SUCCESS );
+}
+
+bStatus_t DevInfo_GetParameter( uint8 param, void *value )
+{
+  (void)param; (void)value;
+  return ( INVALIDPARAMETER );
+}
+
+bStatus_t Batt_AddService( void )
+{
+  return ( SUCCESS );
+}
+
+uint8 Batt_MeasLevel( void )
+{
+  return simBattLevel;
+}
+
+bStatus_t Batt_GetParameter( uint8 param, void *value )
+{
+  if ( param != BATT_PARAM_LEVEL )
+  {
+    return ( INVALIDPARAMETER );
+  }
+  *(uint8 *)value = simBattLevel;
+  return ( SUCCESS );
+}
+
+void simSetBatteryLevel( uint8 level )
+{
+  simBattLevel = level;
+}
+
+uint8 simAdvertData( uint8 *pData )
+{
+  memcpy( pData, simAdvData, simAdvLen );
+  return simAdvLen;
+}
+
+uint16 simAdvertInterval( void )
+{
+  return simAdvInterval;
+}
+
+uint8 HCI_EXT_ClkDivOnHaltCmd( uint8 control )
+{
+  simSetClkDivOnHalt( control == HCI_EXT_ENABLE_CLK_DIVIDE_ON_HALT );
+  return ( SUCCESS );
+}
+
+void HalAdcInit( void )
+{
+}
+
+void halSleep( uint32 osal_timer )
+{
+  (void)osal_timer;
+}
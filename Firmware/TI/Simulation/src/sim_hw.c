@@ -0,0 +1,685 @@
+/**************************************************************************************************
+  Filename:       sim_hw.c
+
+  Description:    CC254x peripheral models for the RoboRoach host simulation:
+                  SFR storage, the interrupt table, Timer 1 (modulo mode with
+                  buffered compare registers and pin outputs), USART0 in SPI
+                  master mode talking to an MCP4251, and the sleep timer.
+
+                  Only the behaviour the RoboRoach firmware relies on is modelled.
+
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <ioCC2540.h>
+#include "hal_mcu.h"
+#include "comdef.h"
+
+#include "sim.h"
+
+/*********************************************************************
+ * SFR storage
+ */
+
+volatile simSfr_t simP0, simP1, simP2;
+volatile simSfr_t simIEN0, simIEN1, simIEN2;
+volatile simSfr_t simTCON, simIRCON, simIRCON2, simS0CON, simS1CON;
+
+volatile uint8_t P0SEL, P1SEL, P2SEL, P0DIR, P1DIR, P2DIR, PERCFG, APCFG;
+volatile uint8_t CLKCONCMD, CLKCONSTA, SLEEPCMD, SLEEPSTA, PCON;
+volatile uint8_t U0GCR, U0BAUD, U0UCR;
+volatile uint8_t T1CTL, T1STAT, T1CNTH;
+volatile uint8_t T1CC0L, T1CC0H, T1CC1L, T1CC1H, T1CC2L, T1CC2H, T1CC3L, T1CC3H, T1CC4L, T1CC4H;
+volatile uint8_t T1CCTL0, T1CCTL1, T1CCTL2, T1CCTL3, T1CCTL4, TIMIF;
+volatile uint8_t T4CTL, T4CNT, T4CCTL0, T4CC0, T4CCTL1, T4CC1;
+volatile uint8_t ST1, ST2;
+
+/*********************************************************************
+ * Interrupts
+ */
+
+static void (*simIsr[SIM_NUM_VECTORS])( void );
+
+void simRegisterIsr( uint8 vector, void (*isr)( void ) )
+{
+  if ( vector < SIM_NUM_VECTORS )
+  {
+    simIsr[vector] = isr;
+  }
+}
+
+static void simCallIsr( uint8 vector )
+{
+  if ( EA && simIsr[vector] )
+  {
+    simIsr[vector]();
+  }
+}
+
+/*********************************************************************
+ * Timer 1
+ */
+
+#define T1_CHANNELS               5
+
+static uint8    t1Running = 0;
+static uint8    t1ResetRequest = 0;
+static uint8    t1CntlShadow = 0;
+static uint16   t1Counter = 0;
+static uint64_t t1TickBase = 0;        // time at which t1Counter was reached
+static uint16   t1Top = 0;
+static uint16   t1Cmp[T1_CHANNELS];
+static uint8    t1Out[T1_CHANNELS];
+
+volatile uint8_t *simT1CNTL( void )
+{
+  t1ResetRequest = 1;
+  t1CntlShadow = (uint8)t1Counter;
+  return &t1CntlShadow;
+}
+
+static uint64_t t1TickCycles( void )
+{
+  static const uint8 shift[4] = { 0, 3, 5, 7 };   // /1, /8, /32, /128
+
+  return 1ULL << shift[( T1CTL >> 2 ) & 0x03];
+}
+
+static volatile uint8_t *t1CctlReg( uint8 n )
+{
+  switch ( n )
+  {
+    case 0: return &T1CCTL0;
+    case 1: return &T1CCTL1;
+    case 2: return &T1CCTL2;
+    case 3: return &T1CCTL3;
+    default: return &T1CCTL4;
+  }
+}
+
+static uint16 t1CcReg( uint8 n )
+{
+  switch ( n )
+  {
+    case 0: return BUILD_UINT16( T1CC0L, T1CC0H );
+    case 1: return BUILD_UINT16( T1CC1L, T1CC1H );
+    case 2: return BUILD_UINT16( T1CC2L, T1CC2H );
+    case 3: return BUILD_UINT16( T1CC3L, T1CC3H );
+    default: return BUILD_UINT16( T1CC4L, T1CC4H );
+  }
+}
+
+static uint8 t1Compare( uint8 n )
+{
+  return ( *t1CctlReg( n ) & 0x04 ) != 0;
+}
+
+// Counter reached 0: compare registers are loaded and "on 0" outputs act
+static void t1AtZero( void )
+{
+  uint8 n;
+
+  t1Top = t1CcReg( 0 );
+  for ( n = 0; n < T1_CHANNELS; n++ )
+  {
+    t1Cmp[n] = t1CcReg( n );
+    if ( t1Compare( n ) )
+    {
+      uint8 cmp = ( *t1CctlReg( n ) >> 3 ) & 0x07;
+
+      if ( cmp == 3 )
+      {
+        t1Out[n] = 0;
+      }
+      else if ( cmp == 4 )
+      {
+        t1Out[n] = 1;
+      }
+    }
+  }
+}
+
+// Counter reached the compare value of channel n
+static void t1AtCompare( uint8 n )
+{
+  uint8 ctl = *t1CctlReg( n );
+
+  switch ( ( ctl >> 3 ) & 0x07 )
+  {
+    case 0: t1Out[n] = 1; break;
+    case 1: t1Out[n] = 0; break;
+    case 2: t1Out[n] ^= 1; break;
+    case 3: t1Out[n] = 1; break;
+    case 4: t1Out[n] = 0; break;
+    default: break;
+  }
+
+  T1STAT |= ( 1 << n );
+  if ( ctl & 0x40 )
+  {
+    T1IF = 1;
+  }
+}
+
+// Pick up register writes made by the firmware since the last look
+static void t1Sync( uint64_t now )
+{
+  uint8 running = ( T1CTL & 0x03 ) != 0;
+
+  if ( running && ( !t1Running || t1ResetRequest ) )
+  {
+    t1Counter = 0;
+    t1TickBase = now;
+    t1AtZero();
+  }
+  else if ( !running && t1ResetRequest )
+  {
+    t1Counter = 0;
+  }
+  t1ResetRequest = 0;
+  t1Running = running;
+}
+
+// Ticks from the current count to the next wrap or enabled compare
+static uint32 t1TicksToEdge( void )
+{
+  uint32 ticks = (uint32)t1Top - t1Counter + 1;
+  uint8 n;
+
+  for ( n = 1; n < T1_CHANNELS; n++ )
+  {
+    if ( t1Compare( n ) && ( t1Cmp[n] > t1Counter ) && ( t1Cmp[n] <= t1Top ) )
+    {
+      uint32 d = t1Cmp[n] - t1Counter;
+
+      if ( d < ticks )
+      {
+        ticks = d;
+      }
+    }
+  }
+  return ticks;
+}
+
+static uint64_t t1NextEdge( void )
+{
+  if ( !t1Running )
+  {
+    return UINT64_MAX;
+  }
+  return t1TickBase + t1TicksToEdge() * t1TickCycles();
+}
+
+static void t1Advance( uint64_t to )
+{
+  while ( t1Running )
+  {
+    uint64_t edge = t1NextEdge();
+    uint32 ticks = t1TicksToEdge();
+    uint8 n;
+
+    if ( edge > to )
+    {
+      uint64_t elapsed = ( to - t1TickBase ) / t1TickCycles();
+
+      t1Counter += (uint16)elapsed;
+      t1TickBase += elapsed * t1TickCycles();
+      return;
+    }
+
+    t1TickBase = edge;
+    if ( (uint32)t1Counter + ticks > t1Top )
+    {
+      t1Counter = 0;
+      T1STAT |= 0x20;   // OVFIF
+      t1AtZero();
+    }
+    else
+    {
+      t1Counter += (uint16)ticks;
+      for ( n = 1; n < T1_CHANNELS; n++ )
+      {
+        if ( t1Compare( n ) && ( t1Cmp[n] == t1Counter ) )
+        {
+          t1AtCompare( n );
+        }
+      }
+    }
+
+    simHwSample();
+    if ( T1IF && T1IE )
+    {
+      simCallIsr( T1_VECTOR );
+      t1Sync( edge );
+      simHwSample();
+    }
+  }
+}
+
+// Timer 1 output on a port pin, if the pin is a Timer 1 channel
+static uint8 t1PinOutput( uint8 port, uint8 bit, uint8 *pValue )
+{
+  static const uint8 alt1[T1_CHANNELS][2] = { {0,2}, {0,3}, {0,4}, {0,5}, {0,6} };
+  static const uint8 alt2[T1_CHANNELS][2] = { {1,2}, {1,1}, {1,0}, {0,7}, {0,6} };
+  const uint8 (*map)[2] = ( PERCFG & 0x40 ) ? alt2 : alt1;
+  uint8 n;
+
+  for ( n = 0; n < T1_CHANNELS; n++ )
+  {
+    if ( map[n][0] == port && map[n][1] == bit )
+    {
+      *pValue = t1Out[n];
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*********************************************************************
+ * Port pins
+ */
+
+static uint8 simPin( uint8 port, uint8 bit )
+{
+  uint8 latch = ( port == 0 ) ? simP0.byte : ( port == 1 ) ? simP1.byte : simP2.byte;
+  uint8 sel = ( port == 0 ) ? P0SEL : ( port == 1 ) ? P1SEL : P2SEL;
+  uint8 value;
+
+  if ( ( sel & ( 1 << bit ) ) && t1PinOutput( port, bit, &value ) )
+  {
+    return value;
+  }
+  return ( latch >> bit ) & 0x01;
+}
+
+/*********************************************************************
+ * USART0 SPI master and the MCP4251 digipot
+ */
+
+#define U0CSR_ACTIVE              0x01
+#define U0CSR_TX_BYTE             0x02
+#define U0CSR_RX_BYTE             0x04
+
+// U0DBUF is a one byte buffer in front of the shift register. A byte
+// written to it moves into the shift register as soon as that is free,
+// and UTX0IF is raised right then: the interrupt means "buffer free", not
+// "byte out". TX_BYTE and URX0IF are set when a byte has left the shift
+// register (in master mode the received byte is complete at the same time).
+static uint8    u0Csr = 0;
+static uint8    u0Dbuf = 0;
+static uint8    u0BufFull = 0;      // written to U0DBUF, not shifting yet
+static uint64_t u0BufTime = 0;      // when it was written
+static uint8    u0Shifting = 0;
+static uint8    u0ShiftByte = 0;
+static uint64_t u0ShiftDone = 0;    // when the byte in the shift register is out
+static uint8    u0CutShort = 0;     // CS went high while it was shifting
+static uint32   u0Bytes = 0;
+static uint32   u0CutBytes = 0;
+
+static uint8  mcpPhase = 0;
+static uint8  mcpCommand = 0;
+static uint16 mcpReg[16];
+
+// Chip select is P0_4, driven as GPIO by the firmware
+static uint8 mcpSelected( void )
+{
+  return ( simP0.byte & 0x10 ) == 0;
+}
+
+static uint8 mcpTransfer( uint8 mosi )
+{
+  uint8 miso = 0xFF;
+
+  if ( !mcpSelected() )
+  {
+    mcpPhase = 0;
+    return miso;
+  }
+
+  if ( mcpPhase == 0 )
+  {
+    mcpCommand = mosi;
+    mcpPhase = 1;
+    miso = 0xFE | ( ( mcpReg[mosi >> 4] >> 8 ) & 0x01 );
+  }
+  else
+  {
+    uint8 addr = mcpCommand >> 4;
+
+    switch ( ( mcpCommand >> 2 ) & 0x03 )
+    {
+      case 0:   // write data
+        mcpReg[addr] = ( (uint16)( mcpCommand & 0x01 ) << 8 ) | mosi;
+        break;
+      case 3:   // read data
+        miso = (uint8)mcpReg[addr];
+        break;
+      default:
+        break;
+    }
+    mcpPhase = 0;
+  }
+  return miso;
+}
+
+static uint64_t u0ByteCycles( void )
+{
+  // SCK = (256 + BAUD_M) * 2^BAUD_E / 2^28 * 32 MHz; 8 bits per byte
+  uint64_t m = 256 + U0BAUD;
+  uint8 e = U0GCR & 0x1F;
+  uint64_t div = ( 1ULL << 28 ) / ( m << e );
+
+  return ( div ? div : 1 ) * 8;
+}
+
+// The MCP4251 only takes a command whose 16 clocks all came with CS low
+static void u0WatchCs( void )
+{
+  if ( u0Shifting && !mcpSelected() && !u0CutShort )
+  {
+    u0CutShort = 1;
+    printf( "%10llu us  spi: CS released during a byte\n", (unsigned long long)simNowUs() );
+  }
+}
+
+static void u0Load( uint64_t at )
+{
+  u0ShiftByte = u0Dbuf;
+  u0BufFull = 0;
+  u0Shifting = 1;
+  u0ShiftDone = at + u0ByteCycles();
+  u0CutShort = 0;
+  u0WatchCs();
+  UTX0IF = 1;
+}
+
+static void u0Finish( void )
+{
+  uint8 miso = 0xFF;
+
+  if ( u0CutShort )
+  {
+    mcpPhase = 0;
+    u0CutBytes++;
+  }
+  else
+  {
+    miso = mcpTransfer( u0ShiftByte );
+  }
+  u0Csr |= U0CSR_TX_BYTE | U0CSR_RX_BYTE;
+  URX0IF = 1;
+  u0Shifting = 0;
+  u0Bytes++;
+  if ( u0BufFull )
+  {
+    u0Load( u0ShiftDone );
+  }
+  u0Dbuf = miso;
+}
+
+// Bring the shift register up to the given time
+static void u0Sync( uint64_t now )
+{
+  if ( u0BufFull && !u0Shifting )
+  {
+    u0Load( u0BufTime );
+  }
+  while ( u0Shifting && ( u0ShiftDone <= now ) )
+  {
+    u0Finish();
+  }
+}
+
+// The firmware polls U0CSR: it waits out the byte in the shift register
+static void u0ShiftWaiting( void )
+{
+  uint64_t now = simNowCharged();
+
+  if ( u0ShiftDone > now )
+  {
+    simCharge( u0ShiftDone - now );
+  }
+  u0Finish();
+  simHwSample();
+}
+
+// Nobody polls: bytes end on their own and raise the RX interrupt, and the
+// TX interrupt as the next one moves into the shift register
+static void u0Advance( uint64_t to )
+{
+  u0WatchCs();
+  u0Sync( to );
+  simHwSample();
+  if ( URX0IF && URX0IE )
+  {
+    simCallIsr( URX0_VECTOR );
+    u0WatchCs();
+    simHwSample();
+  }
+  if ( UTX0IF && ( IEN2 & UTX0IE_BV ) )
+  {
+    simCallIsr( UTX0_VECTOR );
+    u0WatchCs();
+    simHwSample();
+  }
+}
+
+volatile uint8_t *simU0CSR( void )
+{
+  if ( !mcpSelected() )
+  {
+    mcpPhase = 0;
+  }
+  u0WatchCs();
+  u0Sync( simNowCharged() );
+  if ( u0Shifting )
+  {
+    u0ShiftWaiting();
+  }
+  u0Csr = ( u0Csr & ~U0CSR_ACTIVE ) | ( ( u0Shifting || u0BufFull ) ? U0CSR_ACTIVE : 0 );
+  return &u0Csr;
+}
+
+volatile uint8_t *simU0DBUF( void )
+{
+  // The firmware clears TX_BYTE before loading a byte and reads the
+  // received byte while TX_BYTE is still set
+  u0WatchCs();
+  u0Sync( simNowCharged() );
+  if ( !( u0Csr & U0CSR_TX_BYTE ) )
+  {
+    if ( u0BufFull )
+    {
+      // Overwriting a byte that never went out; wait it in instead
+      u0ShiftWaiting();
+    }
+    u0BufFull = 1;
+    u0BufTime = simNowCharged();
+  }
+  else
+  {
+    u0Csr &= ~U0CSR_RX_BYTE;
+  }
+  return &u0Dbuf;
+}
+
+uint8 simWiper( uint8 n )
+{
+  return (uint8)( ( mcpReg[n] > 0xFF ) ? 0xFF : mcpReg[n] );
+}
+
+uint32 simSpiBytes( void )
+{
+  return u0Bytes;
+}
+
+uint32 simSpiCutBytes( void )
+{
+  return u0CutBytes;
+}
+
+/*********************************************************************
+ * Sleep timer (32.768 kHz)
+ */
+
+static uint8 st0Latch;
+
+volatile uint8_t *simST0( void )
+{
+  uint32 st = (uint32)( simNow() * 32768ULL / ( 1000000ULL * SIM_CYCLES_PER_US ) ) & 0xFFFFFF;
+
+  st0Latch = (uint8)st;
+  ST1 = (uint8)( st >> 8 );
+  ST2 = (uint8)( st >> 16 );
+  return &st0Latch;
+}
+
+/*********************************************************************
+ * Clock divide on halt (set through the HCI extension command)
+ */
+
+static uint8 simClkDiv = 0;
+
+uint8 simClkDivOnHalt( void )
+{
+  return simClkDiv;
+}
+
+void simSetClkDivOnHalt( uint8 enabled )
+{
+  simClkDiv = enabled;
+}
+
+/*********************************************************************
+ * Observed signals, for the default (1.21) board in roboRoach.h
+ */
+
+static const struct
+{
+  const char *name;
+  uint8 port;
+  uint8 bit;
+  uint8 width;      // 1 for a pin level, 9 for a wiper
+} simSignals[SIM_NUM_SIGNALS] =
+{
+  { "antenna_left",  1, 1, 1 },
+  { "antenna_right", 1, 0, 1 },
+  { "led_left",      1, 6, 1 },
+  { "led_right",     1, 7, 1 },
+  { "led_conn_1",    1, 5, 1 },
+  { "led_conn_2",    1, 4, 1 },
+  { "wiper_0",       0, 0, 9 },
+  { "wiper_1",       0, 0, 9 },
+};
+
+static uint32 simSignalLast[SIM_NUM_SIGNALS];
+static simTraceCB_t simTrace = NULL;
+
+const char *simSignalName( uint8 signal )
+{
+  return simSignals[signal].name;
+}
+
+uint32 simSignalValue( uint8 signal )
+{
+  if ( signal == SIM_SIG_WIPER_0 )
+  {
+    return mcpReg[0];
+  }
+  if ( signal == SIM_SIG_WIPER_1 )
+  {
+    return mcpReg[1];
+  }
+  return simPin( simSignals[signal].port, simSignals[signal].bit );
+}
+
+uint8 simSignalWidth( uint8 signal )
+{
+  return simSignals[signal].width;
+}
+
+void simSetTrace( simTraceCB_t pfnTrace )
+{
+  uint8 i;
+
+  simTrace = pfnTrace;
+  for ( i = 0; i < SIM_NUM_SIGNALS; i++ )
+  {
+    simSignalLast[i] = simSignalValue( i );
+    if ( simTrace )
+    {
+      simTrace( simNow(), i, simSignalLast[i] );
+    }
+  }
+}
+
+// Look at the pins after firmware ran; report changes at the current time
+void simHwSample( void )
+{
+  uint8 i;
+
+  t1Sync( simNow() );
+  for ( i = 0; i < SIM_NUM_SIGNALS; i++ )
+  {
+    uint32 value = simSignalValue( i );
+
+    if ( value != simSignalLast[i] )
+    {
+      simSignalLast[i] = value;
+      if ( simTrace )
+      {
+        simTrace( simNow(), i, value );
+      }
+    }
+  }
+}
+
+/*********************************************************************
+ * Model stepping
+ */
+
+void simHwInit( void )
+{
+  memset( mcpReg, 0, sizeof( mcpReg ) );
+  mcpReg[0] = mcpReg[1] = 0x80;   // MCP4251 power-on wiper is mid-scale
+  mcpReg[4] = 0x1FF;
+  EA = 1;
+  PERCFG = 0;
+  T1CTL = 0;
+  T1CCTL0 = T1CCTL1 = T1CCTL2 = T1CCTL3 = T1CCTL4 = 0x40;
+  TIMIF = 0x40;
+  U0BAUD = 0;
+  U0GCR = 0;
+  IEN2 = 0;
+  URX0IE = 0;
+  URX0IF = 0;
+  u0BufFull = 0;
+  u0Shifting = 0;
+  t1Running = 0;
+}
+
+uint64_t simHwNextEvent( uint64_t now )
+{
+  uint64_t next;
+
+  t1Sync( now );
+  next = t1NextEdge();
+  if ( u0BufFull && !u0Shifting && ( u0BufTime < next ) )
+  {
+    next = ( u0BufTime > now ) ? u0BufTime : now;
+  }
+  if ( u0Shifting && ( u0ShiftDone < next ) )
+  {
+    next = u0ShiftDone;
+  }
+  return next;
+}
+
+void simHwAdvance( uint64_t from, uint64_t to )
+{
+  (void)from;
+  t1Advance( to );
+  u0Advance( to );
+}
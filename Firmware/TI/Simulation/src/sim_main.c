@@ -0,0 +1,637 @@
+/**************************************************************************************************
+  Filename:       sim_main.c
+
+  Description:    Scenario driver for the RoboRoach host simulation. Boots the
+                  application task against the fake stack, plays the central's
+                  side of a session and checks what the firmware did on the
+                  pins, the notifications and its timers.
+
+                  Usage: roboroach_sim [-o trace.vcd] [scenario...]
+                  Scenarios: boot, timer1, osal, retune, live, gaingap, persist,
+                  presets, latency (ROBOROACH_LATENCY_STATS builds), timeout,
+                  advrace, sleep (default: all, in order, sharing one device). -o
+                  writes every pin and wiper change to a VCD file for
+                  vcd_analyze.
+
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "OSAL.h"
+#include "osal_snv.h"
+#include "att.h"
+#include "peripheral.h"
+#include "roboRoach.h"
+#include "roboRoachApp.h"
+#include "roboRoachTimer.h"
+#include "roboRoachPulse.h"
+#include "MCP4000.h"
+
+#include "sim.h"
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint32 simRises[SIM_NUM_SIGNALS];
+static uint32 simWiperInPulse = 0;   // wiper moves while an antenna was high
+static uint64_t simLeftFall = 0;     // cycles at the last antenna_left fall
+static uint32 simLeftMaxGapUs = 0;   // longest antenna_left gap since the counts were cleared
+static uint8  simVcdPaused = FALSE;
+static uint32 simStatusCount[ROBOROACH_STATUS_QUEUED + 1];
+static uint8  simFailed = 0;
+
+// Parameters saved by an earlier session: the defaults at 60 Hz
+static uint8 simSavedConfig[ROBOROACH_CONFIG_LEN] =
+  { ROBOROACH_CONFIG_VERSION, 60, 9, 100, 0, 50, 40, 100, 1, 9, 50, 50, 0, 0, 0, 0 };
+
+/*********************************************************************
+ * Observers
+ */
+
+static void simOnTrace( uint64_t cycles, uint8 signal, uint32 value )
+{
+  static uint32 last[SIM_NUM_SIGNALS];
+
+  if ( !simVcdPaused )
+  {
+    simVcdTrace( cycles, signal, value );
+  }
+  if ( ( signal < SIM_SIG_WIPER_0 ) && value && !last[signal] )
+  {
+    simRises[signal]++;
+  }
+  if ( signal == SIM_SIG_ANTENNA_LEFT )
+  {
+    if ( !value && last[signal] )
+    {
+      simLeftFall = cycles;
+    }
+    else if ( value && !last[signal] && simLeftFall &&
+              ( ( cycles - simLeftFall ) / SIM_CYCLES_PER_US > simLeftMaxGapUs ) )
+    {
+      simLeftMaxGapUs = (uint32)( ( cycles - simLeftFall ) / SIM_CYCLES_PER_US );
+    }
+  }
+  if ( ( signal >= SIM_SIG_WIPER_0 ) && ( last[SIM_SIG_ANTENNA_LEFT] || last[SIM_SIG_ANTENNA_RIGHT] ) )
+  {
+    printf( "%10llu us  wiper %u moved during a pulse\n", (unsigned long long)simNowUs(),
+            signal - SIM_SIG_WIPER_0 );
+    simWiperInPulse++;
+  }
+  last[signal] = value;
+}
+
+// Keep a train out of the VCD; on resume the trace catches up with the
+// current level of every signal
+static void simPauseVcd( uint8 paused )
+{
+  uint8 i;
+
+  simVcdPaused = paused;
+  if ( !paused )
+  {
+    for ( i = 0; i < SIM_NUM_SIGNALS; i++ )
+    {
+      simVcdTrace( simNow(), i, simSignalValue( i ) );
+    }
+  }
+}
+
+static void simOnNotify( uint16 uuid, uint8 *pValue, uint8 len )
+{
+  uint8 i;
+
+  printf( "%10llu us  notify 0x%04X:", (unsigned long long)simNowUs(), uuid );
+  for ( i = 0; i < len; i++ )
+  {
+    printf( " %02X", pValue[i] );
+  }
+  printf( "\n" );
+
+  if ( ( uuid == ROBOROACH_CHAR_STATUS_UUID ) && ( len == ROBOROACH_STATUS_LEN ) &&
+       ( pValue[1] <= ROBOROACH_STATUS_QUEUED ) )
+  {
+    simStatusCount[pValue[1]]++;
+  }
+}
+
+static void simExpect( int ok, const char *what )
+{
+  printf( "%10llu us  %s: %s\n", (unsigned long long)simNowUs(), ok ? "ok  " : "FAIL", what );
+  if ( !ok )
+  {
+    simFailed = 1;
+  }
+}
+
+static void simClearCounts( void )
+{
+  memset( simRises, 0, sizeof( simRises ) );
+  memset( simStatusCount, 0, sizeof( simStatusCount ) );
+  simLeftFall = 0;
+  simLeftMaxGapUs = 0;
+}
+
+static void simWrite8( uint16 uuid, uint8 value )
+{
+  if ( simGattWrite( uuid, &value, 1, TRUE ) != SUCCESS )
+  {
+    simFailed = 1;
+  }
+}
+
+static void simWrite16( uint16 uuid, uint16 value )
+{
+  uint8 data[2] = { LO_UINT16( value ), HI_UINT16( value ) };
+
+  if ( simGattWrite( uuid, data, 2, TRUE ) != SUCCESS )
+  {
+    simFailed = 1;
+  }
+}
+
+static void simRunFor( uint32 ms )
+{
+  simRunUntil( simNow() + SIM_MS( ms ) );
+}
+
+// The status beacon fields of the advertisement, NULL if there are none
+static uint8 *simBeacon( void )
+{
+  static uint8 adv[31];
+  uint8 len = simAdvertData( adv );
+  uint8 i = 0;
+
+  while ( ( i + 1 < len ) && adv[i] )
+  {
+    if ( ( adv[i + 1] == GAP_ADTYPE_MANUFACTURER_SPECIFIC ) &&
+         ( adv[i] == 3 + ROBOROACH_BEACON_LEN ) && ( i + 1 + adv[i] <= len ) &&
+         ( BUILD_UINT16( adv[i + 2], adv[i + 3] ) == ROBOROACH_BEACON_COMPANY_ID ) )
+    {
+      return &adv[i + 4];
+    }
+    i += 1 + adv[i];
+  }
+  return NULL;
+}
+
+/*********************************************************************
+ * Scenarios
+ */
+
+// Power up, advertise and blink the LEDs, then accept a connection
+static void simScenarioBoot( void )
+{
+  uint8 state;
+  uint8 value;
+  uint8 len = sizeof( value );
+  uint8 *pBeacon;
+  uint32 flashes;
+
+  simRunFor( 2500 );
+  simExpect( simRises[SIM_SIG_LED_LEFT] >= 2, "advertising blink on the steering LEDs" );
+  simExpect( simAdvertInterval() == BYB_ADV_FAST_INTERVAL, "fast advertising after power up" );
+  pBeacon = simBeacon();
+  simExpect( ( pBeacon != NULL ) &&
+             ( pBeacon[ROBOROACH_BEACON_OFS_BATTERY] == 100 ) &&
+             ( pBeacon[ROBOROACH_BEACON_OFS_FW_MAJOR] == ROBOROACH_FIRMWARE_VERSION_MAJOR ) &&
+             ( pBeacon[ROBOROACH_BEACON_OFS_FW_MINOR] == ROBOROACH_FIRMWARE_VERSION_MINOR ) &&
+             ( pBeacon[ROBOROACH_BEACON_OFS_HARDWARE] == ROBOROACH_HARDWARE_REV ) &&
+             ( pBeacon[ROBOROACH_BEACON_OFS_SHORT_ID] == 0x01 ) &&
+             ( pBeacon[ROBOROACH_BEACON_OFS_SHORT_ID + 1] == 0x02 ) &&
+             ( pBeacon[ROBOROACH_BEACON_OFS_STATE] == 0 ) &&
+             ( pBeacon[ROBOROACH_BEACON_OFS_PRESET] == ROBOROACH_PRESET_NONE ), "status beacon advertised" );
+
+  simBleConnect();
+  GAPRole_GetParameter( GAPROLE_STATE, &state );
+  simExpect( state == GAPROLE_CONNECTED, "connected" );
+  simExpect( simSignalValue( SIM_SIG_LED_CONNECTION_1 ) && simSignalValue( SIM_SIG_LED_CONNECTION_2 ),
+             "connection LEDs flash on connect" );
+  flashes = simRises[SIM_SIG_LED_CONNECTION_1];
+  simRunFor( 2 * BYB_CONNECT_LED_PERIOD + 100 );
+  simExpect( ( simRises[SIM_SIG_LED_CONNECTION_1] - flashes == 2 ) &&
+             ( simSignalValue( SIM_SIG_LED_CONNECTION_1 ) == 0 ), "connection LEDs flash every period" );
+  simExpect( !simPwrmgrHeld(), "32 MHz clock released while connected" );
+  simExpect( simGattEnableNotify( ROBOROACH_CHAR_STATUS_UUID ) == SUCCESS,
+             "status notifications enabled" );
+  simExpect( ( simGattRead( ROBOROACH_CHAR_FREQUENCY_UUID, &value, &len ) == SUCCESS ) &&
+             ( value == 60 ), "saved parameters restored" );
+}
+
+// 50 Hz, 10 ms pulses for 100 ms: the train runs on Timer 1
+static void simScenarioTimer1( void )
+{
+  simClearCounts();
+  simWrite8( ROBOROACH_CHAR_FREQUENCY_UUID, 50 );
+  simWrite8( ROBOROACH_CHAR_PULSE_WIDTH_UUID, 10 );
+  simWrite8( ROBOROACH_CHAR_DURATION_IN_5MS_UUID, 20 );
+  simWrite8( ROBOROACH_CHAR_STIMULATE_LEFT_UUID, 1 );
+  simRunFor( 500 );
+
+  printf( "%10llu us  antenna_left pulses %lu, SPI bytes %lu\n",
+          (unsigned long long)simNowUs(), (unsigned long)simRises[SIM_SIG_ANTENNA_LEFT],
+          (unsigned long)simSpiBytes() );
+  simExpect( simRises[SIM_SIG_ANTENNA_LEFT] >= 5, "left antenna pulsed" );
+  simExpect( simRises[SIM_SIG_ANTENNA_RIGHT] == 0, "right antenna idle" );
+  simExpect( ( simStatusCount[ROBOROACH_STATUS_STARTED] == 1 ) &&
+             ( simStatusCount[ROBOROACH_STATUS_FINISHED] == 1 ), "started and finished notified" );
+  simExpect( ( simWiper( 0 ) == Gain_PercentToWiper( 50 ) ) &&
+             ( simWiper( 1 ) == Gain_PercentToWiper( 50 ) ), "both wipers at the train gain" );
+  simExpect( simSpiCutBytes() == 0, "CS held low for whole digipot writes" );
+}
+
+// 2 Hz is too slow for Timer 1, so the pulses come from OSAL timers
+static void simScenarioOsal( void )
+{
+  simClearCounts();
+  simWrite8( ROBOROACH_CHAR_FREQUENCY_UUID, 2 );
+  simWrite8( ROBOROACH_CHAR_PULSE_WIDTH_UUID, 10 );
+  simWrite8( ROBOROACH_CHAR_DURATION_IN_5MS_UUID, 200 );
+  simWrite8( ROBOROACH_CHAR_STIMULATE_RIGHT_UUID, 1 );
+  simRunFor( 2000 );
+
+  printf( "%10llu us  antenna_right pulses %lu\n",
+          (unsigned long long)simNowUs(), (unsigned long)simRises[SIM_SIG_ANTENNA_RIGHT] );
+  simExpect( simRises[SIM_SIG_ANTENNA_RIGHT] >= 2, "right antenna pulsed" );
+  simExpect( simStatusCount[ROBOROACH_STATUS_FINISHED] == 1, "finished notified" );
+}
+
+// New parameters written during a train wait for the next one
+static void simScenarioRetune( void )
+{
+  // Idle long enough for vcd_analyze to split it from the osal train
+  simRunFor( 1000 );
+  simClearCounts();
+  simWrite8( ROBOROACH_CHAR_FREQUENCY_UUID, 2 );
+  simWrite8( ROBOROACH_CHAR_PULSE_WIDTH_UUID, 10 );
+  simWrite8( ROBOROACH_CHAR_DURATION_IN_5MS_UUID, 200 );
+  simWrite8( ROBOROACH_CHAR_STIMULATE_RIGHT_UUID, 1 );
+  simRunFor( 250 );
+  simWrite8( ROBOROACH_CHAR_FREQUENCY_UUID, 50 );
+  simWrite8( ROBOROACH_CHAR_GAIN_UUID, 80 );
+  simRunFor( 1750 );
+
+  printf( "%10llu us  antenna_right pulses %lu\n",
+          (unsigned long long)simNowUs(), (unsigned long)simRises[SIM_SIG_ANTENNA_RIGHT] );
+  simExpect( simRises[SIM_SIG_ANTENNA_RIGHT] == 2, "train kept the parameters it started with" );
+  simExpect( simWiper( 0 ) == Gain_PercentToWiper( 50 ), "gain unchanged during the train" );
+  simExpect( simStatusCount[ROBOROACH_STATUS_FINISHED] == 1, "finished notified" );
+
+  // Back to the values of the osal scenario for the next train
+  simWrite8( ROBOROACH_CHAR_FREQUENCY_UUID, 2 );
+  simWrite8( ROBOROACH_CHAR_GAIN_UUID, 50 );
+}
+
+// With Live Update on, a gain write reaches the running train at the
+// next pulse, on Timer 1 and on OSAL timers; the trains keep their timing
+static void simScenarioLive( void )
+{
+  simRunFor( 1000 );
+  simClearCounts();
+  simWrite8( ROBOROACH_CHAR_LIVE_UPDATE_UUID, 1 );
+
+  simWrite8( ROBOROACH_CHAR_FREQUENCY_UUID, 50 );
+  simWrite8( ROBOROACH_CHAR_DURATION_IN_5MS_UUID, 20 );
+  simWrite8( ROBOROACH_CHAR_STIMULATE_LEFT_UUID, 1 );
+  simRunFor( 30 );
+  simWrite8( ROBOROACH_CHAR_GAIN_UUID, 80 );
+  simRunFor( 21 );
+  simExpect( ( simWiper( 0 ) == Gain_PercentToWiper( 80 ) ) &&
+             ( simWiper( 1 ) == Gain_PercentToWiper( 80 ) ), "Timer 1 train took the gain mid-train" );
+  simRunFor( 1949 );
+  simExpect( simRises[SIM_SIG_ANTENNA_LEFT] == 5, "Timer 1 train kept its length" );
+
+  simWrite8( ROBOROACH_CHAR_FREQUENCY_UUID, 2 );
+  simWrite8( ROBOROACH_CHAR_DURATION_IN_5MS_UUID, 200 );
+  simWrite8( ROBOROACH_CHAR_STIMULATE_RIGHT_UUID, 1 );
+  simRunFor( 250 );
+  simWrite8( ROBOROACH_CHAR_GAIN_UUID, 50 );
+  simRunFor( 500 );
+  simExpect( simWiper( 0 ) == Gain_PercentToWiper( 50 ), "OSAL train took the gain at the next pulse" );
+  simRunFor( 1250 );
+
+  printf( "%10llu us  antenna_left pulses %lu, antenna_right pulses %lu\n",
+          (unsigned long long)simNowUs(), (unsigned long)simRises[SIM_SIG_ANTENNA_LEFT],
+          (unsigned long)simRises[SIM_SIG_ANTENNA_RIGHT] );
+  simExpect( simRises[SIM_SIG_ANTENNA_RIGHT] == 2, "OSAL train kept its length" );
+  simExpect( simStatusCount[ROBOROACH_STATUS_FINISHED] == 2, "finished notified" );
+
+  simWrite8( ROBOROACH_CHAR_LIVE_UPDATE_UUID, 0 );
+}
+
+// 950 us pulses every 1 ms leave a 50 us gap, too short for the wiper
+// writes: the gap before the first pulse at the new gain is stretched for
+// them. Kept out of the VCD, whose antenna_left trains are checked
+// against the timer1 scenario.
+static void simScenarioGainGap( void )
+{
+  uint32 inPulse = simWiperInPulse;
+
+  simRunFor( 1000 );
+  simClearCounts();
+  simPauseVcd( TRUE );
+  simWrite8( ROBOROACH_CHAR_LIVE_UPDATE_UUID, 1 );
+
+  simWrite16( ROBOROACH_CHAR_PULSE_WIDTH_US_UUID, 950 );
+  simWrite16( ROBOROACH_CHAR_PERIOD_US_UUID, 1000 );
+  simWrite8( ROBOROACH_CHAR_DURATION_IN_5MS_UUID, 20 );
+  simWrite8( ROBOROACH_CHAR_STIMULATE_LEFT_UUID, 1 );
+  simRunFor( 30 );
+  simWrite8( ROBOROACH_CHAR_GAIN_UUID, 80 );
+  simRunFor( 5 );
+  simExpect( ( simWiper( 0 ) == Gain_PercentToWiper( 80 ) ) &&
+             ( simWiper( 1 ) == Gain_PercentToWiper( 80 ) ), "gain taken through a short gap" );
+  simRunFor( 965 );
+  printf( "%10llu us  antenna_left pulses %lu, longest gap %lu us\n", (unsigned long long)simNowUs(),
+          (unsigned long)simRises[SIM_SIG_ANTENNA_LEFT], (unsigned long)simLeftMaxGapUs );
+  simExpect( simRises[SIM_SIG_ANTENNA_LEFT] >= 99, "short gap train ran" );
+  simExpect( simLeftMaxGapUs >= ROBOROACH_PULSE_GAIN_GAP_US, "gap stretched for the wiper writes" );
+  simExpect( simWiperInPulse == inPulse, "wipers only moved between pulses" );
+
+  simWrite16( ROBOROACH_CHAR_PULSE_WIDTH_US_UUID, 0 );
+  simWrite16( ROBOROACH_CHAR_PERIOD_US_UUID, 0 );
+  simWrite8( ROBOROACH_CHAR_GAIN_UUID, 50 );
+  simWrite8( ROBOROACH_CHAR_LIVE_UPDATE_UUID, 0 );
+  simPauseVcd( FALSE );
+}
+
+// Parameter writes are saved to SNV once they stop coming, and only
+// when the values changed
+static void simScenarioPersist( void )
+{
+  uint8  config[ROBOROACH_CONFIG_LEN];
+  uint32 writes;
+
+  // Let the saves of the earlier scenarios finish
+  simRunFor( BYB_PARAMS_SAVE_DELAY );
+  writes = simSnvWrites();
+
+  simWrite8( ROBOROACH_CHAR_GAIN_UUID, 70 );
+  simRunFor( 100 );
+  simWrite8( ROBOROACH_CHAR_FREQUENCY_UUID, 60 );
+  simRunFor( 100 );
+  simWrite8( ROBOROACH_CHAR_GAIN_UUID, 65 );
+  simRunFor( BYB_PARAMS_SAVE_DELAY - 100 );
+  simExpect( simSnvWrites() == writes, "nothing saved while writes come in" );
+  simRunFor( 200 );
+  simExpect( simSnvWrites() == writes + 1, "one save for the whole burst" );
+  simExpect( ( osal_snv_read( ROBOROACH_NV_PARAMS, sizeof( config ), config ) == SUCCESS ) &&
+             ( config[ROBOROACH_CONFIG_OFS_FREQUENCY] == 60 ) &&
+             ( config[ROBOROACH_CONFIG_OFS_GAIN] == 65 ), "saved values are the last written" );
+
+  simWrite8( ROBOROACH_CHAR_FREQUENCY_UUID, 60 );
+  simRunFor( BYB_PARAMS_SAVE_DELAY + 100 );
+  simExpect( simSnvWrites() == writes + 1, "unchanged values not saved again" );
+}
+
+// Two protocols uploaded once, then switched with one byte each
+static void simScenarioPresets( void )
+{
+  uint8 gentle[ROBOROACH_PRESET_UPLOAD_LEN] =
+    { 0, ROBOROACH_CONFIG_VERSION, 30, 5, 100, 0, 40, 40, 100, 1, 9, 40, 60, 0, 0, 0, 0 };
+  uint8 strong[ROBOROACH_PRESET_UPLOAD_LEN] =
+    { 1, ROBOROACH_CONFIG_VERSION, 80, 9, 100, 1, 80, 60, 100, 5, 9, 70, 90, 0, 0, 0, 0 };
+  uint8 value;
+  uint8 len;
+
+  simExpect( ( simGattWrite( ROBOROACH_CHAR_PRESET_UPLOAD_UUID, gentle, sizeof( gentle ), TRUE ) == SUCCESS ) &&
+             ( simGattWrite( ROBOROACH_CHAR_PRESET_UPLOAD_UUID, strong, sizeof( strong ), TRUE ) == SUCCESS ),
+             "presets uploaded" );
+
+  simWrite8( ROBOROACH_CHAR_ACTIVE_PRESET_UUID, 1 );
+  len = 1;
+  simGattRead( ROBOROACH_CHAR_FREQUENCY_UUID, &value, &len );
+  simExpect( value == 80, "strong preset loaded" );
+  len = 1;
+  simGattRead( ROBOROACH_CHAR_RANDOM_MODE_UUID, &value, &len );
+  simExpect( value == 1, "with its random mode" );
+
+  simWrite8( ROBOROACH_CHAR_ACTIVE_PRESET_UUID, 0 );
+  len = 1;
+  simGattRead( ROBOROACH_CHAR_FREQUENCY_UUID, &value, &len );
+  simExpect( value == 30, "gentle preset loaded" );
+  len = 1;
+  simGattRead( ROBOROACH_CHAR_ACTIVE_PRESET_UUID, &value, &len );
+  simExpect( value == 0, "active preset reads back" );
+
+  simWrite8( ROBOROACH_CHAR_GAIN_UUID, 45 );
+  len = 1;
+  simGattRead( ROBOROACH_CHAR_ACTIVE_PRESET_UUID, &value, &len );
+  simExpect( value == ROBOROACH_PRESET_NONE, "parameter write leaves the preset" );
+
+  value = 2;
+  simExpect( simGattWrite( ROBOROACH_CHAR_ACTIVE_PRESET_UUID, &value, 1, TRUE ) == ATT_ERR_INVALID_VALUE,
+             "empty slot rejected" );
+  value = ROBOROACH_NUM_PRESETS;
+  simExpect( simGattWrite( ROBOROACH_CHAR_ACTIVE_PRESET_UUID, &value, 1, TRUE ) == ATT_ERR_INVALID_VALUE,
+             "unknown slot rejected" );
+  len = 1;
+  simGattRead( ROBOROACH_CHAR_GAIN_UUID, &value, &len );
+  simExpect( value == 45, "rejected selection changed nothing" );
+}
+
+#if defined ( ROBOROACH_LATENCY_STATS )
+// Read back the write-to-first-edge statistics of the trains so far
+static void simScenarioLatency( void )
+{
+  static const char *stages[] = { "write-dispatch", "dispatch-start", "start-edge", "write-edge" };
+  uint8  value[4 * ROBOROACH_LATENCY_RECORD_LEN];
+  uint8  len = sizeof( value );
+  uint8  i;
+
+  simExpect( ( simGattRead( ROBOROACH_CHAR_LATENCY_UUID, value, &len ) == SUCCESS ) &&
+             ( len == sizeof( value ) ), "latency statistics read" );
+  for ( i = 0; i < 4; i++ )
+  {
+    uint8 *pRec = &value[i * ROBOROACH_LATENCY_RECORD_LEN];
+
+    printf( "%10llu us  %-14s n %u min %u max %u mean %u us\n", (unsigned long long)simNowUs(),
+            stages[i], BUILD_UINT16( pRec[1], pRec[2] ), BUILD_UINT16( pRec[3], pRec[4] ),
+            BUILD_UINT16( pRec[5], pRec[6] ), BUILD_UINT16( pRec[7], pRec[8] ) );
+  }
+  simExpect( BUILD_UINT16( value[3 * ROBOROACH_LATENCY_RECORD_LEN + 1],
+                           value[3 * ROBOROACH_LATENCY_RECORD_LEN + 2] ) >= 1,
+             "first edges timed" );
+}
+#endif
+
+// Lose the link, back off the advertising interval and wait for the sleep
+// timer: nothing of the task may be left
+// The link times out with a train running and another one queued: the
+// queued one is dropped with the link, and the device heads for sleep.
+// Kept out of the VCD, whose antenna_left trains are checked against the
+// timer1 scenario.
+static void simScenarioTimeout( void )
+{
+  simRunFor( 1000 );
+  simClearCounts();
+  simPauseVcd( TRUE );
+  simWrite8( ROBOROACH_CHAR_COMMAND_POLICY_UUID, ROBOROACH_POLICY_FIFO );
+  simWrite8( ROBOROACH_CHAR_FREQUENCY_UUID, 50 );
+  simWrite8( ROBOROACH_CHAR_DURATION_IN_5MS_UUID, 20 );
+  simWrite8( ROBOROACH_CHAR_STIMULATE_LEFT_UUID, 1 );
+  simWrite8( ROBOROACH_CHAR_STIMULATE_LEFT_UUID, 1 );
+  simExpect( simStatusCount[ROBOROACH_STATUS_QUEUED] == 1, "second train queued" );
+
+  simBleTimeout();
+  simRunFor( 500 );
+  printf( "%10llu us  antenna_left pulses %lu\n",
+          (unsigned long long)simNowUs(), (unsigned long)simRises[SIM_SIG_ANTENNA_LEFT] );
+  simExpect( simRises[SIM_SIG_ANTENNA_LEFT] == 5, "queued train dropped with the link" );
+  simExpect( simSignalValue( SIM_SIG_LED_CONNECTION_2 ) == 0, "connection LED off" );
+  simExpect( ( RoboRoachTimer_Active() & BYB_SLEEP_EVT ) != 0, "sleep timer armed" );
+  simExpect( ( RoboRoachTimer_Active() & BYB_CONN_IDLE_EVT ) == 0, "idle timer stopped" );
+  simExpect( simAdvertInterval() == BYB_ADV_FAST_INTERVAL, "fast advertising after the timeout" );
+  simPauseVcd( FALSE );
+
+  simBleConnect();
+  simRunFor( 10 );
+  simWrite8( ROBOROACH_CHAR_COMMAND_POLICY_UUID, ROBOROACH_POLICY_DROP );
+}
+
+// A central connecting while advertising is restarted at a new interval:
+// once that link is gone the disconnect must be handled as any other
+static void simScenarioAdvertRace( void )
+{
+  simBleDisconnect();
+  simRunFor( 10 );
+  simBleConnectOnRestart();
+  simRunFor( BYB_ADV_FAST_PERIOD + 500 );
+  simExpect( simBleConnected(), "connected while advertising restarted" );
+
+  simBleDisconnect();
+  simRunFor( 10 );
+  simExpect( simSignalValue( SIM_SIG_LED_CONNECTION_2 ) == 0, "connection LED off" );
+  simExpect( simAdvertInterval() == BYB_ADV_FAST_INTERVAL, "fast advertising after the link is lost" );
+
+  simBleConnect();
+  simRunFor( 10 );
+}
+
+static void simScenarioSleep( void )
+{
+  uint8 *pBeacon;
+  uint8 preset;
+  uint8 len = sizeof( preset );
+
+  simGattRead( ROBOROACH_CHAR_ACTIVE_PRESET_UUID, &preset, &len );
+  simSetBatteryLevel( 80 );
+  simBleDisconnect();
+  simExpect( simSignalValue( SIM_SIG_LED_CONNECTION_2 ) == 0, "connection LED off" );
+  simRunFor( 10 );
+  pBeacon = simBeacon();
+  simExpect( ( pBeacon != NULL ) && ( pBeacon[ROBOROACH_BEACON_OFS_BATTERY] == 80 ) &&
+             ( pBeacon[ROBOROACH_BEACON_OFS_PRESET] == preset ), "beacon refreshed when advertising again" );
+  simExpect( simAdvertInterval() == BYB_ADV_FAST_INTERVAL, "fast advertising after the link is lost" );
+
+  // A restart outlasting a blink must not end the blinks (and the back off)
+  simBleReportDelay( 2 * BYB_ADV_PULSE_WIDTH );
+  simRunFor( BYB_ADV_FAST_PERIOD + 500 );
+  simExpect( simAdvertInterval() == BYB_ADV_MEDIUM_INTERVAL, "advertising backed off" );
+  simRunFor( BYB_ADV_MEDIUM_PERIOD );
+  simExpect( simAdvertInterval() == BYB_ADV_SLOW_INTERVAL, "advertising backed off again" );
+  simBleReportDelay( 0 );
+  simRunFor( BYB_DISCONNECT_PERIOD_B4_SLEEP - BYB_ADV_FAST_PERIOD - BYB_ADV_MEDIUM_PERIOD + 500 );
+
+  simExpect( RoboRoachTimer_Active() == 0, "timer registry empty" );
+  simExpect( simActiveTimers( SIM_APP_TASK_ID ) == 0, "no OSAL timer left for the task" );
+  simExpect( simPendingEvents( SIM_APP_TASK_ID ) == 0, "no event left for the task" );
+  simExpect( !simPwrmgrHeld(), "32 MHz clock released" );
+  simExpect( simSpiCutBytes() == 0, "no digipot write cut short by CS" );
+  simExpect( simWiperInPulse == 0, "no wiper moved during a pulse" );
+}
+
+static const struct
+{
+  const char *name;
+  void (*pfnRun)( void );
+} simScenarios[] =
+{
+  { "boot",   simScenarioBoot   },
+  { "timer1", simScenarioTimer1 },
+  { "osal",   simScenarioOsal   },
+  { "retune", simScenarioRetune },
+  { "live",   simScenarioLive   },
+  { "gaingap", simScenarioGainGap },
+  { "persist", simScenarioPersist },
+  { "presets", simScenarioPresets },
+#if defined ( ROBOROACH_LATENCY_STATS )
+  { "latency", simScenarioLatency },
+#endif
+  { "timeout", simScenarioTimeout },
+  { "advrace", simScenarioAdvertRace },
+  { "sleep",  simScenarioSleep  },
+};
+
+#define SIM_NUM_SCENARIOS   ( sizeof( simScenarios ) / sizeof( simScenarios[0] ) )
+
+static int simRunScenario( const char *name )
+{
+  uint8 i;
+
+  for ( i = 0; i < SIM_NUM_SCENARIOS; i++ )
+  {
+    if ( strcmp( name, simScenarios[i].name ) == 0 )
+    {
+      printf( "--- %s\n", name );
+      simScenarios[i].pfnRun();
+      return 0;
+    }
+  }
+  fprintf( stderr, "unknown scenario '%s'\n", name );
+  return -1;
+}
+
+/*********************************************************************
+ * Main
+ */
+
+int main( int argc, char **argv )
+{
+  int first = 1;
+  int i;
+
+  simOsalInit();
+  simHwInit();
+  simSetTrace( simOnTrace );
+  simSetNotifyCB( simOnNotify );
+
+  if ( ( argc > 2 ) && ( strcmp( argv[1], "-o" ) == 0 ) )
+  {
+    if ( !simVcdOpen( argv[2] ) )
+    {
+      fprintf( stderr, "cannot write '%s'\n", argv[2] );
+      return 2;
+    }
+    first = 3;
+  }
+
+  osal_snv_write( ROBOROACH_NV_PARAMS, sizeof( simSavedConfig ), simSavedConfig );
+  RoboRoachPeripheral_Init( SIM_APP_TASK_ID );
+  simBleStart();
+
+  if ( argc <= first )
+  {
+    for ( i = 0; i < (int)SIM_NUM_SCENARIOS; i++ )
+    {
+      simRunScenario( simScenarios[i].name );
+    }
+  }
+  else
+  {
+    for ( i = first; i < argc; i++ )
+    {
+      if ( simRunScenario( argv[i] ) != 0 )
+      {
+        simVcdClose();
+        return 2;
+      }
+    }
+  }
+
+  simVcdClose();
+  printf( "%s\n", simFailed ? "FAILED" : "PASSED" );
+  return simFailed ? 1 : 0;
+}
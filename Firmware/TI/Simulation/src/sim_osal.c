@@ -0,0 +1,551 @@
+/**************************************************************************************************
+  Filename:       sim_osal.c
+
+  Description:    OSAL stand-in for the RoboRoach host simulation: task events,
+                  millisecond timers, messages, power manager and SNV, all driven
+                  by a virtual clock instead of the CC254x sleep timer.
+
+**************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "OSAL.h"
+#include "OSAL_PwrMgr.h"
+#include "osal_snv.h"
+#include "roboRoachApp.h"
+
+#include "sim.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define SIM_MAX_TIMERS            32
+#define SIM_MAX_MSGS              16
+#define SIM_SNV_ITEMS             256
+#define SIM_SNV_ITEM_LEN          255
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint8    inUse;
+  uint8    taskId;
+  uint16   event;
+  uint64_t expiry;
+  uint32   reload;
+} simTimer_t;
+
+typedef struct
+{
+  uint8    destination;
+  uint8   *pMsg;
+} simMsg_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint64_t   simClock = 0;
+static uint64_t   simDebt = 0;
+static uint16     simEvents[SIM_NUM_TASKS];
+static simTimer_t simTimers[SIM_MAX_TIMERS];
+static simMsg_t   simMsgs[SIM_MAX_MSGS];
+static uint8      simMsgCount = 0;
+static uint32     simRandState = 0x1234;
+static uint32     simHeld = 0;
+
+static uint8      simSnvValid[SIM_SNV_ITEMS];
+static uint8      simSnvLen[SIM_SNV_ITEMS];
+static uint8      simSnv[SIM_SNV_ITEMS][SIM_SNV_ITEM_LEN];
+static uint32     simSnvWriteCount = 0;
+
+/*********************************************************************
+ * Virtual clock
+ */
+
+uint64_t simNow( void )
+{
+  return simClock;
+}
+
+uint64_t simNowUs( void )
+{
+  return simClock / SIM_CYCLES_PER_US;
+}
+
+// Firmware spent this long busy-waiting; applied when control returns to the scheduler
+void simCharge( uint64_t cycles )
+{
+  simDebt += cycles;
+}
+
+// Time as the firmware sees it, busy-waits charged so far included
+uint64_t simNowCharged( void )
+{
+  return simClock + simDebt;
+}
+
+static uint64_t simNextTimer( void )
+{
+  uint64_t next = UINT64_MAX;
+  uint8 i;
+
+  for ( i = 0; i < SIM_MAX_TIMERS; i++ )
+  {
+    if ( simTimers[i].inUse && simTimers[i].expiry < next )
+    {
+      next = simTimers[i].expiry;
+    }
+  }
+  return next;
+}
+
+static void simFireTimers( void )
+{
+  uint8 i;
+
+  for ( i = 0; i < SIM_MAX_TIMERS; i++ )
+  {
+    if ( simTimers[i].inUse && simTimers[i].expiry <= simClock )
+    {
+      simEvents[simTimers[i].taskId] |= simTimers[i].event;
+      if ( simTimers[i].reload )
+      {
+        simTimers[i].expiry += SIM_MS( simTimers[i].reload );
+      }
+      else
+      {
+        simTimers[i].inUse = 0;
+      }
+    }
+  }
+}
+
+// Move the clock forward, letting the hardware models run. Stops early
+// when a model raised an interrupt so the tasks can react at that time.
+static void simAdvance( uint64_t to )
+{
+  while ( simClock < to )
+  {
+    uint64_t next = simHwNextEvent( simClock );
+
+    if ( next > to )
+    {
+      next = to;
+    }
+    {
+      uint64_t from = simClock;
+
+      simClock = next;
+      simHwAdvance( from, next );
+    }
+    simFireTimers();
+  }
+}
+
+static void simPayDebt( void )
+{
+  while ( simDebt )
+  {
+    uint64_t debt = simDebt;
+
+    simDebt = 0;
+    simAdvance( simClock + debt );
+  }
+}
+
+// A NOP in a firmware spin loop: one cycle passes, and with it whatever
+// the hardware models and their interrupts do meanwhile
+void simNop( void )
+{
+  simCharge( 1 );
+  simPayDebt();
+}
+
+void simRunTasks( void )
+{
+  uint8 busy = 1;
+
+  while ( busy )
+  {
+    uint8 task;
+
+    busy = 0;
+    simFireTimers();
+    for ( task = 0; task < SIM_NUM_TASKS; task++ )
+    {
+      if ( simEvents[task] )
+      {
+        uint16 events = simEvents[task];
+
+        simEvents[task] = 0;
+        if ( task == SIM_APP_TASK_ID )
+        {
+          events = RoboRoachPeripheral_ProcessEvent( task, events );
+        }
+        else if ( task == SIM_BLE_TASK_ID )
+        {
+          events = simBleProcessEvent( task, events );
+        }
+        else
+        {
+          events = 0;   // other stack tasks are not simulated
+        }
+        simEvents[task] |= events;
+        simHwSample();
+        simPayDebt();
+        busy = 1;
+        break;          // highest priority task first, as OSAL does
+      }
+    }
+  }
+}
+
+void simRunUntil( uint64_t cycles )
+{
+  for ( ;; )
+  {
+    uint64_t next;
+
+    simRunTasks();
+    simPayDebt();
+    if ( simClock >= cycles )
+    {
+      break;
+    }
+
+    next = simNextTimer();
+    if ( next > cycles )
+    {
+      next = cycles;
+    }
+    if ( next < simClock )
+    {
+      next = simClock;
+    }
+
+    // simAdvance returns early on interrupts through simHwNextEvent
+    {
+      uint64_t hw = simHwNextEvent( simClock );
+      if ( hw < next )
+      {
+        next = hw;
+      }
+    }
+    if ( next == simClock )
+    {
+      next = simClock + 1;
+    }
+    simAdvance( next );
+  }
+}
+
+void simOsalInit( void )
+{
+  memset( simEvents, 0, sizeof( simEvents ) );
+  memset( simTimers, 0, sizeof( simTimers ) );
+  simMsgCount = 0;
+  simClock = 0;
+  simDebt = 0;
+  simHeld = 0;
+}
+
+uint8 simPwrmgrHeld( void )
+{
+  return ( simHeld != 0 );
+}
+
+uint16 simPendingEvents( uint8 taskId )
+{
+  return simEvents[taskId];
+}
+
+uint32 simActiveTimers( uint8 taskId )
+{
+  uint32 mask = 0;
+  uint8 i;
+
+  for ( i = 0; i < SIM_MAX_TIMERS; i++ )
+  {
+    if ( simTimers[i].inUse && simTimers[i].taskId == taskId )
+    {
+      mask |= simTimers[i].event;
+    }
+  }
+  return mask;
+}
+
+/*********************************************************************
+ * OSAL events and messages
+ */
+
+uint8 osal_set_event( uint8 task_id, uint16 event_flag )
+{
+  if ( task_id >= SIM_NUM_TASKS )
+  {
+    return ( INVALID_TASK );
+  }
+  simEvents[task_id] |= event_flag;
+  return ( SUCCESS );
+}
+
+uint8 osal_clear_event( uint8 task_id, uint16 event_flag )
+{
+  if ( task_id >= SIM_NUM_TASKS )
+  {
+    return ( INVALID_TASK );
+  }
+  simEvents[task_id] &= ~event_flag;
+  return ( SUCCESS );
+}
+
+uint8 *osal_msg_allocate( uint16 len )
+{
+  return (uint8 *)calloc( 1, len );
+}
+
+uint8 osal_msg_deallocate( uint8 *msg_ptr )
+{
+  free( msg_ptr );
+  return ( SUCCESS );
+}
+
+uint8 osal_msg_send( uint8 destination_task, uint8 *msg_ptr )
+{
+  if ( simMsgCount == SIM_MAX_MSGS )
+  {
+    free( msg_ptr );
+    return ( MSG_BUFFER_NOT_AVAIL );
+  }
+  simMsgs[simMsgCount].destination = destination_task;
+  simMsgs[simMsgCount].pMsg = msg_ptr;
+  simMsgCount++;
+  return osal_set_event( destination_task, SYS_EVENT_MSG );
+}
+
+uint8 *osal_msg_receive( uint8 task_id )
+{
+  uint8 i;
+
+  for ( i = 0; i < simMsgCount; i++ )
+  {
+    if ( simMsgs[i].destination == task_id )
+    {
+      uint8 *pMsg = simMsgs[i].pMsg;
+
+      memmove( &simMsgs[i], &simMsgs[i + 1], ( simMsgCount - i - 1 ) * sizeof( simMsg_t ) );
+      simMsgCount--;
+      for ( i = 0; i < simMsgCount; i++ )
+      {
+        if ( simMsgs[i].destination == task_id )
+        {
+          osal_set_event( task_id, SYS_EVENT_MSG );
+        }
+      }
+      return pMsg;
+    }
+  }
+  return NULL;
+}
+
+uint16 osal_rand( void )
+{
+  simRandState = simRandState * 1103515245UL + 12345UL;
+  return (uint16)( simRandState >> 16 );
+}
+
+void *osal_memcpy( void *dst, const void *src, unsigned int len )
+{
+  memcpy( dst, src, len );
+  return (uint8 *)dst + len;
+}
+
+void *osal_memset( void *dest, uint8 value, int len )
+{
+  return memset( dest, value, len );
+}
+
+uint8 osal_memcmp( const void *src1, const void *src2, unsigned int len )
+{
+  return ( memcmp( src1, src2, len ) == 0 );
+}
+
+void *osal_mem_alloc( uint16 size )
+{
+  return malloc( size );
+}
+
+void osal_mem_free( void *ptr )
+{
+  free( ptr );
+}
+
+/*********************************************************************
+ * OSAL timers
+ */
+
+static simTimer_t *simFindTimer( uint8 task_id, uint16 event_id )
+{
+  uint8 i;
+
+  for ( i = 0; i < SIM_MAX_TIMERS; i++ )
+  {
+    if ( simTimers[i].inUse && simTimers[i].taskId == task_id && simTimers[i].event == event_id )
+    {
+      return &simTimers[i];
+    }
+  }
+  return NULL;
+}
+
+static uint8 simAddTimer( uint8 task_id, uint16 event_id, uint32 timeout, uint32 reload )
+{
+  simTimer_t *pTimer = simFindTimer( task_id, event_id );
+  uint8 i;
+
+  for ( i = 0; ( pTimer == NULL ) && ( i < SIM_MAX_TIMERS ); i++ )
+  {
+    if ( !simTimers[i].inUse )
+    {
+      pTimer = &simTimers[i];
+    }
+  }
+  if ( pTimer == NULL )
+  {
+    return ( NO_TIMER_AVAIL );
+  }
+
+  pTimer->inUse = 1;
+  pTimer->taskId = task_id;
+  pTimer->event = event_id;
+  pTimer->expiry = simClock + SIM_MS( timeout );
+  pTimer->reload = reload;
+  return ( SUCCESS );
+}
+
+uint8 osal_start_timerEx( uint8 task_id, uint16 event_id, uint32 timeout_value )
+{
+  return simAddTimer( task_id, event_id, timeout_value, 0 );
+}
+
+uint8 osal_start_reload_timer( uint8 task_id, uint16 event_id, uint32 timeout_value )
+{
+  return simAddTimer( task_id, event_id, timeout_value, timeout_value );
+}
+
+uint8 osal_stop_timerEx( uint8 task_id, uint16 event_id )
+{
+  simTimer_t *pTimer = simFindTimer( task_id, event_id );
+
+  if ( pTimer == NULL )
+  {
+    return ( INVALID_EVENT_ID );
+  }
+  pTimer->inUse = 0;
+  return ( SUCCESS );
+}
+
+uint32 osal_get_timeoutEx( uint8 task_id, uint16 event_id )
+{
+  simTimer_t *pTimer = simFindTimer( task_id, event_id );
+
+  if ( pTimer == NULL )
+  {
+    return 0;
+  }
+  return (uint32)( ( pTimer->expiry - simClock + SIM_MS( 1 ) - 1 ) / SIM_MS( 1 ) );
+}
+
+uint32 osal_GetSystemClock( void )
+{
+  return (uint32)( simClock / SIM_MS( 1 ) );
+}
+
+uint32 osal_next_timeout( void )
+{
+  uint64_t next = simNextTimer();
+
+  return ( next == UINT64_MAX ) ? 0 : (uint32)( ( next - simClock ) / SIM_MS( 1 ) );
+}
+
+/*********************************************************************
+ * Power manager
+ */
+
+void osal_pwrmgr_init( void )
+{
+  simHeld = 0;
+}
+
+void osal_pwrmgr_device( uint8 pwrmgr_device )
+{
+  (void)pwrmgr_device;
+}
+
+uint8 osal_pwrmgr_task_state( uint8 task_id, uint8 state )
+{
+  if ( task_id >= SIM_NUM_TASKS )
+  {
+    return ( INVALID_TASK );
+  }
+  if ( state == PWRMGR_HOLD )
+  {
+    simHeld |= ( 1UL << task_id );
+  }
+  else
+  {
+    simHeld &= ~( 1UL << task_id );
+  }
+  return ( SUCCESS );
+}
+
+void osal_pwrmgr_powerconserve( void )
+{
+  printf( "%10llu us  power: sleep\n", (unsigned long long)simNowUs() );
+}
+
+/*********************************************************************
+ * Simple NV
+ */
+
+uint8 osal_snv_init( void )
+{
+  return ( SUCCESS );
+}
+
+uint8 osal_snv_read( osalSnvId_t id, osalSnvLen_t len, void *pBuf )
+{
+  if ( !simSnvValid[id] )
+  {
+    return ( NV_OPER_FAILED );
+  }
+  memcpy( pBuf, simSnv[id], ( len < simSnvLen[id] ) ? len : simSnvLen[id] );
+  return ( SUCCESS );
+}
+
+uint8 osal_snv_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf )
+{
+  memcpy( simSnv[id], pBuf, len );
+  simSnvLen[id] = len;
+  simSnvValid[id] = 1;
+  simSnvWriteCount++;
+  // A flash page write stalls the CPU for about 20 us per word written
+  simCharge( SIM_US( 20 ) * ( ( len + 3 ) / 4 ) );
+  return ( SUCCESS );
+}
+
+uint32 simSnvWrites( void )
+{
+  return simSnvWriteCount;
+}
+
+uint8 osal_snv_compact( uint8 threshold )
+{
+  (void)threshold;
+  return ( SUCCESS );
+}
@@ -0,0 +1,113 @@
+/**************************************************************************************************
+  Filename:       sim_vcd.c
+
+  Description:    Waveform capture for the RoboRoach host simulation. Every change
+                  of an observed signal is written to a Value Change Dump with
+                  1 us resolution: pins as 1-bit wires, MCP4251 wipers as
+                  9-bit vectors. The file opens in GTKWave and
+                  is the input of vcd_analyze.
+
+**************************************************************************************************/
+
+#include <stdio.h>
+
+#include "sim.h"
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static FILE    *vcdFile = NULL;
+static uint64_t vcdTime = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+// One printable identifier character per signal
+static char vcdId( uint8 signal )
+{
+  return (char)( '!' + signal );
+}
+
+static void vcdValue( uint8 signal, uint32 value )
+{
+  uint8 width = simSignalWidth( signal );
+
+  if ( width == 1 )
+  {
+    fprintf( vcdFile, "%u%c\n", value ? 1 : 0, vcdId( signal ) );
+  }
+  else
+  {
+    int8 bit;
+
+    fputc( 'b', vcdFile );
+    for ( bit = (int8)( width - 1 ); bit >= 0; bit-- )
+    {
+      fputc( ( value >> bit ) & 0x01 ? '1' : '0', vcdFile );
+    }
+    fprintf( vcdFile, " %c\n", vcdId( signal ) );
+  }
+}
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+// Start a dump with the current value of every signal at the current time
+uint8 simVcdOpen( const char *path )
+{
+  uint8 i;
+
+  vcdFile = fopen( path, "w" );
+  if ( vcdFile == NULL )
+  {
+    return ( FALSE );
+  }
+
+  fprintf( vcdFile, "$comment RoboRoach host simulation $end\n" );
+  fprintf( vcdFile, "$timescale 1us $end\n" );
+  fprintf( vcdFile, "$scope module roboroach $end\n" );
+  for ( i = 0; i < SIM_NUM_SIGNALS; i++ )
+  {
+    fprintf( vcdFile, "$var %s %u %c %s $end\n", ( simSignalWidth( i ) == 1 ) ? "wire" : "reg",
+             simSignalWidth( i ), vcdId( i ), simSignalName( i ) );
+  }
+  fprintf( vcdFile, "$upscope $end\n$enddefinitions $end\n" );
+
+  vcdTime = simNowUs();
+  fprintf( vcdFile, "#%llu\n$dumpvars\n", (unsigned long long)vcdTime );
+  for ( i = 0; i < SIM_NUM_SIGNALS; i++ )
+  {
+    vcdValue( i, simSignalValue( i ) );
+  }
+  fprintf( vcdFile, "$end\n" );
+  return ( TRUE );
+}
+
+void simVcdTrace( uint64_t cycles, uint8 signal, uint32 value )
+{
+  uint64_t us = cycles / SIM_CYCLES_PER_US;
+
+  if ( vcdFile == NULL )
+  {
+    return;
+  }
+  if ( us != vcdTime )
+  {
+    vcdTime = us;
+    fprintf( vcdFile, "#%llu\n", (unsigned long long)us );
+  }
+  vcdValue( signal, value );
+}
+
+void simVcdClose( void )
+{
+  if ( vcdFile != NULL )
+  {
+    fprintf( vcdFile, "#%llu\n", (unsigned long long)simNowUs() );
+    fclose( vcdFile );
+    vcdFile = NULL;
+  }
+}
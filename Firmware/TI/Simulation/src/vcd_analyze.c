@@ -0,0 +1,331 @@
+/**************************************************************************************************
+  Filename:       vcd_analyze.c
+
+  Description:    Timing report for one pin of a waveform dump written by the host
+                  simulation (or any VCD with a 1-bit wire). Pulses are grouped
+                  into trains, split wherever the pin stays low longer than the
+                  split time, and each train is measured:
+
+                    frequency  - 1 / mean rising-edge period
+                    width      - mean, min and max high time
+                    duration   - pulses x mean period (one pulse: its width)
+                    jitter     - rms and peak deviation of the periods and
+                                 widths from their mean
+
+                  Given the requested values, the error of each is reported and
+                  the exit status is 1 when one is off by more than the
+                  tolerance, so the report can gate a build.
+
+                  Usage: vcd_analyze FILE SIGNAL [-f Hz] [-w us] [-d ms]
+                                     [-t percent] [-j us] [-s ms]
+
+**************************************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define MAX_EDGES                 65536
+#define MAX_LINE                  256
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static double    timescaleUs = 1.0;
+static double    riseUs[MAX_EDGES];
+static double    fallUs[MAX_EDGES];
+static unsigned  numPulses = 0;
+
+static double    reqFreq = 0, reqWidthUs = 0, reqDurationMs = 0;
+static double    tolerancePct = 1.0;
+static double    maxJitterUs = -1.0;
+static double    splitMs = 1500.0;
+static int       failed = 0;
+
+/*********************************************************************
+ * VCD input
+ */
+
+static double parseTimescale( const char *text )
+{
+  double value = atof( text );
+  const char *unit = text;
+
+  while ( *unit && ( ( *unit >= '0' && *unit <= '9' ) || *unit == ' ' || *unit == '.' ) )
+  {
+    unit++;
+  }
+  if ( value == 0 )
+  {
+    value = 1;
+  }
+  if ( strncmp( unit, "fs", 2 ) == 0 ) return value * 1e-9;
+  if ( strncmp( unit, "ps", 2 ) == 0 ) return value * 1e-6;
+  if ( strncmp( unit, "ns", 2 ) == 0 ) return value * 1e-3;
+  if ( strncmp( unit, "us", 2 ) == 0 ) return value;
+  if ( strncmp( unit, "ms", 2 ) == 0 ) return value * 1e3;
+  return value * 1e6;
+}
+
+// Collect the rising and falling edges of the named wire
+static int readVcd( const char *path, const char *signal )
+{
+  FILE *f = fopen( path, "r" );
+  char line[MAX_LINE];
+  char id[32] = "";
+  double now = 0;
+  int level = -1;
+  int inTimescale = 0;
+
+  if ( f == NULL )
+  {
+    fprintf( stderr, "cannot read '%s'\n", path );
+    return -1;
+  }
+
+  while ( fgets( line, sizeof( line ), f ) )
+  {
+    char *p = line;
+
+    while ( *p == ' ' || *p == '\t' )
+    {
+      p++;
+    }
+
+    if ( inTimescale || strncmp( p, "$timescale", 10 ) == 0 )
+    {
+      char *t = inTimescale ? p : p + 10;
+
+      while ( *t == ' ' || *t == '\t' || *t == '\n' )
+      {
+        t++;
+      }
+      if ( *t && *t != '$' )
+      {
+        timescaleUs = parseTimescale( t );
+      }
+      inTimescale = ( strstr( p, "$end" ) == NULL );
+      continue;
+    }
+
+    if ( strncmp( p, "$var", 4 ) == 0 )
+    {
+      char type[32], ref[128], varId[32];
+      unsigned width;
+
+      if ( ( sscanf( p, "$var %31s %u %31s %127s", type, &width, varId, ref ) == 4 ) &&
+           ( strcmp( ref, signal ) == 0 ) )
+      {
+        if ( width != 1 )
+        {
+          fprintf( stderr, "'%s' is not a 1-bit signal\n", signal );
+          fclose( f );
+          return -1;
+        }
+        strcpy( id, varId );
+      }
+      continue;
+    }
+
+    if ( *p == '#' )
+    {
+      now = atof( p + 1 ) * timescaleUs;
+      continue;
+    }
+
+    if ( ( id[0] != '\0' ) && ( *p == '0' || *p == '1' || *p == 'x' || *p == 'z' ) )
+    {
+      char *end = p + 1 + strlen( id );
+
+      if ( ( strncmp( p + 1, id, strlen( id ) ) == 0 ) && ( *end == '\n' || *end == '\0' || *end == '\r' ) )
+      {
+        int value = ( *p == '1' );
+
+        if ( ( level == 0 ) && value && ( numPulses < MAX_EDGES ) )
+        {
+          riseUs[numPulses] = now;
+          fallUs[numPulses] = -1;
+        }
+        else if ( ( level == 1 ) && !value && ( numPulses < MAX_EDGES ) )
+        {
+          fallUs[numPulses++] = now;
+        }
+        else if ( ( level < 0 ) && value && ( numPulses < MAX_EDGES ) )
+        {
+          riseUs[numPulses] = now;    // high from the start of the dump
+        }
+        level = value;
+      }
+    }
+  }
+  fclose( f );
+
+  if ( id[0] == '\0' )
+  {
+    fprintf( stderr, "no signal '%s' in '%s'\n", signal, path );
+    return -1;
+  }
+  return 0;
+}
+
+/*********************************************************************
+ * Report
+ */
+
+static void compare( const char *what, double measured, double requested, const char *unit )
+{
+  double errPct;
+
+  if ( requested <= 0 )
+  {
+    printf( "  %-11s %.3f %s\n", what, measured, unit );
+    return;
+  }
+  errPct = ( measured - requested ) * 100.0 / requested;
+  printf( "  %-11s %.3f %s (requested %.3f, %+.2f%%)%s\n", what, measured, unit, requested, errPct,
+          ( fabs( errPct ) > tolerancePct ) ? "  ** out of tolerance" : "" );
+  if ( fabs( errPct ) > tolerancePct )
+  {
+    failed = 1;
+  }
+}
+
+// Mean, rms and peak deviation of n values
+static void spread( const double *v, unsigned n, double *pMean, double *pRms, double *pPeak )
+{
+  double sum = 0, sq = 0, peak = 0;
+  unsigned i;
+
+  for ( i = 0; i < n; i++ )
+  {
+    sum += v[i];
+  }
+  *pMean = n ? sum / n : 0;
+  for ( i = 0; i < n; i++ )
+  {
+    double d = v[i] - *pMean;
+
+    sq += d * d;
+    if ( fabs( d ) > peak )
+    {
+      peak = fabs( d );
+    }
+  }
+  *pRms = n ? sqrt( sq / n ) : 0;
+  *pPeak = peak;
+}
+
+static void reportTrain( unsigned train, unsigned first, unsigned count )
+{
+  static double periods[MAX_EDGES], widths[MAX_EDGES];
+  double periodMean = 0, periodRms = 0, periodPeak = 0;
+  double widthMean, widthRms, widthPeak, widthMin = 1e300, widthMax = 0;
+  double durationUs;
+  unsigned i;
+
+  for ( i = 0; i < count; i++ )
+  {
+    widths[i] = fallUs[first + i] - riseUs[first + i];
+    if ( widths[i] < widthMin ) widthMin = widths[i];
+    if ( widths[i] > widthMax ) widthMax = widths[i];
+    if ( i > 0 )
+    {
+      periods[i - 1] = riseUs[first + i] - riseUs[first + i - 1];
+    }
+  }
+  spread( widths, count, &widthMean, &widthRms, &widthPeak );
+
+  printf( "train %u: %u pulse%s from %.0f us\n", train, count, ( count == 1 ) ? "" : "s",
+          riseUs[first] );
+  if ( count > 1 )
+  {
+    spread( periods, count - 1, &periodMean, &periodRms, &periodPeak );
+    durationUs = periodMean * count;
+    compare( "frequency", 1e6 / periodMean, reqFreq, "Hz" );
+  }
+  else
+  {
+    durationUs = widthMean;
+    printf( "  frequency   - (single pulse)\n" );
+  }
+  compare( "width", widthMean, reqWidthUs, "us" );
+  printf( "  width range %.0f .. %.0f us\n", widthMin, widthMax );
+  compare( "duration", durationUs / 1000.0, reqDurationMs, "ms" );
+  printf( "  jitter      period rms %.2f us peak %.2f us, width rms %.2f us peak %.2f us\n",
+          periodRms, periodPeak, widthRms, widthPeak );
+
+  if ( ( maxJitterUs >= 0 ) && ( ( periodPeak > maxJitterUs ) || ( widthPeak > maxJitterUs ) ) )
+  {
+    printf( "  ** jitter above %.2f us\n", maxJitterUs );
+    failed = 1;
+  }
+}
+
+/*********************************************************************
+ * Main
+ */
+
+static int usage( void )
+{
+  fprintf( stderr, "usage: vcd_analyze FILE SIGNAL [-f Hz] [-w us] [-d ms] "
+                   "[-t percent] [-j us] [-s ms]\n" );
+  return 2;
+}
+
+int main( int argc, char **argv )
+{
+  unsigned first = 0, train = 0, i;
+  int a;
+
+  if ( argc < 3 )
+  {
+    return usage();
+  }
+  for ( a = 3; a < argc; a++ )
+  {
+    double value;
+
+    if ( ( a + 1 >= argc ) || ( argv[a][0] != '-' ) )
+    {
+      return usage();
+    }
+    value = atof( argv[a + 1] );
+    switch ( argv[a][1] )
+    {
+      case 'f': reqFreq = value;        break;
+      case 'w': reqWidthUs = value;     break;
+      case 'd': reqDurationMs = value;  break;
+      case 't': tolerancePct = value;   break;
+      case 'j': maxJitterUs = value;    break;
+      case 's': splitMs = value;        break;
+      default:  return usage();
+    }
+    a++;
+  }
+
+  if ( readVcd( argv[1], argv[2] ) != 0 )
+  {
+    return 2;
+  }
+  printf( "%s: %u pulse%s\n", argv[2], numPulses, ( numPulses == 1 ) ? "" : "s" );
+  if ( numPulses == 0 )
+  {
+    return ( reqFreq > 0 || reqWidthUs > 0 || reqDurationMs > 0 ) ? 1 : 0;
+  }
+
+  for ( i = 1; i <= numPulses; i++ )
+  {
+    if ( ( i == numPulses ) || ( riseUs[i] - fallUs[i - 1] > splitMs * 1000.0 ) )
+    {
+      reportTrain( ++train, first, i - first );
+      first = i;
+    }
+  }
+  return failed;
+}
@@ -5,11 +5,18 @@
 
   Description:    Control of the digital potentiometer MCP4251 on the RoboRoach board
 
+                  Wiper writes are queued and sent in the background from the
+                  USART0 RX interrupt, so the pulse interrupt does not wait for
+                  the SPI. The callback set with potSetDoneCB() tells the task
+                  when they are on the pot. potInit() and potReadReg() still
+                  busy-wait.
+
   Copyright 2014  Backyard Brains
 
 **************************************************************************************************/
 
 #include <ioCC2540.h>
+#include "hal_mcu.h"
 #include "MCP4000.h"
 
 
@@ -31,16 +38,69 @@
 #define CS_DISABLED     1
 #define CS_ENABLED      0
 
+// U0CSR.TX_BYTE: byte transmitted
+#define U0CSR_TX_BYTE   0x02
+
+// Register writes that can wait for the SPI at once
+#define POT_QUEUE_LEN   4
+
+// Background transfer state
+#define POT_TX_IDLE     0
+#define POT_TX_COMMAND  1   // command byte on the wire
+#define POT_TX_DATA     2   // data byte on the wire
+
 
 //***********************************************************************************
 // Function prototypes
 void spiWriteByte(uint8 write);
 void spiReadByte(uint8 *read, uint8 write);
+static void potStartNext(void);
 
 
 //***********************************************************************************
 // Local variables
 
+// Shadow of the MCP4251 wiper registers, so a value already on the pot is not
+// sent again. A bit in potWiperValid is set once that wiper has been written.
+static uint8 potWiper[2];
+static uint8 potWiperValid = 0;
+
+// Wiper code for each gain percent, round(percent * 255 / 100). Same values
+// the float mapping produced, without pulling in the float library.
+static CODE const uint8 potGainTable[101] =
+{
+      0,   3,   5,   8,  10,  13,  15,  18,  20,  23,
+     26,  28,  31,  33,  36,  38,  41,  43,  46,  48,
+     51,  54,  56,  59,  61,  64,  66,  69,  71,  74,
+     77,  79,  82,  84,  87,  89,  92,  94,  97,  99,
+    102, 105, 107, 110, 112, 115, 117, 120, 122, 125,
+    128, 130, 133, 135, 138, 140, 143, 145, 148, 150,
+    153, 156, 158, 161, 163, 166, 168, 171, 173, 176,
+    179, 181, 184, 186, 189, 191, 194, 196, 199, 201,
+    204, 207, 209, 212, 214, 217, 219, 222, 224, 227,
+    230, 232, 235, 237, 240, 242, 245, 247, 250, 252,
+    255
+};
+
+// Per-board table set with Gain_SetCalibration(), NULL for potGainTable
+static const uint8 *potGainCal = NULL;
+
+// Gain requested with Gain_SetPending(), written by Gain_CommitPending()
+static uint8 potPendingGain = 0;
+static bool  potGainPending = FALSE;
+
+// Register writes waiting for the SPI, oldest first. The head entry is on
+// the wire while potTxState is not idle. Entries are added by the task or
+// the Timer 1 interrupt and taken off by the USART0 RX interrupt.
+static uint8 potQueueReg[POT_QUEUE_LEN];
+static uint8 potQueueVal[POT_QUEUE_LEN];
+static uint8 potQueueHead = 0;
+static volatile uint8 potQueueCount = 0;
+static volatile uint8 potTxState = POT_TX_IDLE;
+
+// Called when the queue has drained
+static potDoneCB_t potDoneCB = NULL;
+
 
 //***********************************************************************************
 // functions
@@ -64,6 +124,12 @@ void potInit(void)
     P0DIR |= 0x10;
 
     CS = CS_DISABLED;
+
+    // Wiper contents are unknown until written once
+    potWiperValid = 0;
+    potGainPending = FALSE;
+    potQueueCount = 0;
+    potTxState = POT_TX_IDLE;
     
     //*** Setup the SPI interface ***
     // SPI master mode  ??? 
@@ -78,7 +144,29 @@ void potInit(void)
 
     //initalize TCON bits 
     potWriteReg(0x04, 0xFF);
-    
+
+    //later writes complete in the RX interrupt
+    URX0IF = 0;
+    URX0IE = 1;
+}
+
+/** \brief	Sets the function called when queued writes are done
+*
+* It runs in the USART0 RX interrupt, once the last queued write is on the
+* pot. NULL for none.
+*/
+void potSetDoneCB(potDoneCB_t pfnDone)
+{
+    potDoneCB = pfnDone;
+}
+
+/** \brief	Checks for writes still queued or on the wire
+*
+* \return  TRUE until the background transfer is complete
+*/
+bool potBusy(void)
+{
+    return (potTxState != POT_TX_IDLE);
 }
 
 
@@ -93,32 +181,185 @@ void potInit(void)
 */
 void potWriteReg(uint8 reg, uint8 val)
 {
+    potWaitIdle();
     CS = CS_ENABLED;
     //bit shift by 4
     spiWriteByte(reg << 4);
     //WRITE VALUE
     spiWriteByte(val);
     CS = CS_DISABLED;
+
+    //keep the wiper shadow in step with the pot
+    if (reg < 2)
+    {
+        potWiper[reg] = val;
+        potWiperValid |= (1 << reg);
+    }
+}
+
+/** \brief	Queues a write of one byte to a digipot register
+*
+* Returns at once; the USART0 RX interrupt sends the write. A write still
+* waiting for the same register takes the new value instead. Callable from
+* the task and from interrupts.
+*
+* \param[in]       reg
+*     Register address
+* \param[in]       val
+*     Value to write
+*
+* \return  FALSE if the queue is full
+*/
+bool potWriteRegAsync(uint8 reg, uint8 val)
+{
+    halIntState_t intState;
+    uint8 i;
+    uint8 slot;
+    bool queued = TRUE;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+
+    // The head entry may already be on the wire; later ones can be merged
+    for (i = (potTxState != POT_TX_IDLE) ? 1 : 0; i < potQueueCount; i++)
+    {
+        slot = (potQueueHead + i) % POT_QUEUE_LEN;
+        if (potQueueReg[slot] == reg)
+        {
+            potQueueVal[slot] = val;
+            break;
+        }
+    }
+
+    if (i == potQueueCount)
+    {
+        if (potQueueCount == POT_QUEUE_LEN)
+        {
+            queued = FALSE;
+        }
+        else
+        {
+            slot = (potQueueHead + potQueueCount) % POT_QUEUE_LEN;
+            potQueueReg[slot] = reg;
+            potQueueVal[slot] = val;
+            potQueueCount++;
+        }
+    }
+
+    if (queued && (potTxState == POT_TX_IDLE))
+    {
+        potStartNext();
+    }
+
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    //keep the wiper shadow in step with what the pot will hold
+    if (queued && (reg < 2))
+    {
+        potWiper[reg] = val;
+        potWiperValid |= (1 << reg);
+    }
+    return queued;
+}
+
+/** \brief	Queues a wiper register write only if it holds a different value
+*
+* \param[in]       wiper
+*     Wiper register address (0 or 1)
+* \param[in]       val
+*     Value to write
+*
+* \return  TRUE if an SPI transaction was queued
+*/
+static bool potWriteWiper(uint8 wiper, uint8 val)
+{
+    if ((potWiperValid & (1 << wiper)) && (potWiper[wiper] == val))
+    {
+        return FALSE;
+    }
+    return potWriteRegAsync(wiper, val);
 }
 
 /* \brief    Sets the gain level on digipot
 *     
 *  takes an uint8 (0 to 100) from user characteristic
 *      and writes to the digipot an uint8 (0 to 255)
+*  Nothing is sent over SPI when the wipers already hold that value.
 */
 void Gain_SetLevel(uint8 userGain)
 {
-    //initialize variables for calculation
-    uint8   gain8bit = 0;
-    float   floatingGain = 0;
+    Gain_SetPending(userGain);
+    Gain_CommitPending();
+}
+
+/* \brief    Maps a gain level to a wiper code
+*
+*  takes an uint8 (0 to 100), larger values are treated as 100
+*  \return  wiper code (0 to 255) from the calibration table
+*/
+uint8 Gain_PercentToWiper(uint8 userGain)
+{
+    if (userGain > 100)
+    {
+        userGain = 100;
+    }
+    if (potGainCal != NULL)
+    {
+        return potGainCal[userGain];
+    }
+    return potGainTable[userGain];
+}
+
+/* \brief    Loads a per-board gain calibration
+*
+*  pTable holds 101 wiper codes indexed by gain percent and must stay
+*  valid while in use. NULL restores the default linear mapping.
+*  The new mapping is applied at the next gain commit.
+*/
+void Gain_SetCalibration(const uint8 *pTable)
+{
+    potGainCal = pTable;
+}
+
+/* \brief    Records the gain level to apply at the next commit
+*
+*  takes an uint8 (0 to 100) from user characteristic
+*/
+void Gain_SetPending(uint8 userGain)
+{
+    potPendingGain = userGain;
+    potGainPending = TRUE;
+}
+
+/* \brief    Writes the pending gain level to the digipot
+*
+*  Called at the end of a pulse so a wiper is never changed while the
+*  antenna is driven. Only wipers whose value differs are written; the
+*  writes are queued and finish in the background, in the gap the pulse
+*  engine keeps for them (ROBOROACH_PULSE_GAIN_GAP_US).
+*
+*  Not reentrant: the Timer 1 interrupt and the application task must not
+*  commit at the same time.
+*
+*  \return  TRUE if a digipot write was queued
+*/
+bool Gain_CommitPending(void)
+{
+    uint8   gain8bit;
+    bool    written;
+
+    if (!potGainPending)
+    {
+        return FALSE;
+    }
+    potGainPending = FALSE;
     
     //mapping userGain (ints: 0 - 100) to gain8bit (ints: 0 - 255)
-    floatingGain = (255.0/100.0) * userGain;
-    gain8bit = (uint8) (floatingGain + 0.5); 
+    gain8bit = Gain_PercentToWiper(potPendingGain);
     
     //update the MCP4250
-    potWriteReg(0x00, gain8bit);  
-    potWriteReg(0x01, gain8bit); 
+    written = potWriteWiper(0x00, gain8bit);
+    written |= potWriteWiper(0x01, gain8bit);
+    return written;
 }
      
 
@@ -133,6 +374,7 @@ void Gain_SetLevel(uint8 userGain)
 */
 void potReadReg(uint8 reg, uint8 *pVal)
 {
+    potWaitIdle();
     CS = CS_ENABLED;
     WAIT_1_3US(2);
     spiWriteByte(reg << 4 | 0x0C);
@@ -174,3 +416,70 @@ void spiReadByte(uint8 *read, uint8 write)
         *read = U0DBUF;
 }
 
+/** \brief	Puts the head of the write queue on the wire
+*
+* Called with interrupts disabled or from the USART0 RX interrupt
+*/
+static void potStartNext(void)
+{
+    CS = CS_ENABLED;
+    potTxState = POT_TX_COMMAND;
+    URX0IF = 0;
+    U0CSR &= ~U0CSR_TX_BYTE;
+    U0DBUF = potQueueReg[potQueueHead] << 4;
+}
+
+/** \brief	Waits until queued writes are on the pot
+*
+* Must not be called with interrupts disabled
+*/
+void potWaitIdle(void)
+{
+    while (potTxState != POT_TX_IDLE)
+    {
+        asm("NOP");
+    }
+}
+
+/** \brief	USART0 RX interrupt: a byte has been clocked out completely
+*
+* In SPI master mode URX0IF is set once the last bit of a byte has shifted,
+* so the command byte interrupt loads the data byte and the data byte
+* interrupt can release CS at once. Then the next queued write starts, or
+* the queue goes idle and the done callback runs. Bytes of the busy-wait
+* functions are ignored.
+*/
+HAL_ISR_FUNCTION(potSpiIsr, URX0_VECTOR)
+{
+    URX0IF = 0;
+
+    switch (potTxState)
+    {
+        case POT_TX_COMMAND:
+            potTxState = POT_TX_DATA;
+            U0CSR &= ~U0CSR_TX_BYTE;
+            U0DBUF = potQueueVal[potQueueHead];
+            break;
+
+        case POT_TX_DATA:
+            CS = CS_DISABLED;
+            potQueueHead = (potQueueHead + 1) % POT_QUEUE_LEN;
+            potQueueCount--;
+            if (potQueueCount != 0)
+            {
+                potStartNext();
+            }
+            else
+            {
+                potTxState = POT_TX_IDLE;
+                if (potDoneCB != NULL)
+                {
+                    potDoneCB();
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
@@ -76,12 +76,26 @@
 
 
 
+//***********************************************************************************
+// Types
+
+// Called from the USART0 RX interrupt when queued writes are done
+typedef void (*potDoneCB_t)(void);
+
 //***********************************************************************************
 // Function prototypes
 void potReadReg(uint8 reg, uint8 *pVal);
 
 void potInit(void);
 void potWriteReg(uint8 reg, uint8 val);
+bool potWriteRegAsync(uint8 reg, uint8 val);
+void potSetDoneCB(potDoneCB_t pfnDone);
+bool potBusy(void);
+void potWaitIdle(void);
 void Gain_SetLevel( uint8 userGain ); 
+void Gain_SetPending( uint8 userGain );
+bool Gain_CommitPending( void );
+uint8 Gain_PercentToWiper( uint8 userGain );
+void Gain_SetCalibration( const uint8 *pTable );
 
 #endif
@@ -36,6 +36,15 @@ extern "C"
 #define ROBOROACH_PW_MAX                  12
 #define ROBOROACH_GAIN_MIN                13
 #define ROBOROACH_GAIN_MAX                14
+#define ROBOROACH_PULSE_WIDTH_US          15
+#define ROBOROACH_PERIOD_US               16
+#define ROBOROACH_COMMAND_POLICY          17
+#define ROBOROACH_CONFIG                  18
+#define ROBOROACH_STATUS                  19
+#define ROBOROACH_EVENT_STATS_RESET       20
+#define ROBOROACH_PARAMS                  21  //any stimulation parameter was written
+#define ROBOROACH_LIVE_UPDATE             22
+#define ROBOROACH_ACTIVE_PRESET           23
   
 // RoboRoach Service UUID
 #define ROBOROACH_SERV_UUID                  0xB2B0
@@ -54,8 +63,95 @@ extern "C"
 #define ROBOROACH_CHAR_PW_MAX_UUID           0xB2BB
 #define ROBOROACH_CHAR_GAIN_MIN_UUID         0xB2BC
 #define ROBOROACH_CHAR_GAIN_MAX_UUID         0xB2BD  
+#define ROBOROACH_CHAR_CONFIG_UUID           0xB2BE  //all stimulation parameters in one write
+#define ROBOROACH_CHAR_PULSE_WIDTH_US_UUID   0xB2C0  //0 = use the ms pulse width
+#define ROBOROACH_CHAR_PERIOD_US_UUID        0xB2C1  //0 = use the frequency
+#define ROBOROACH_CHAR_COMMAND_POLICY_UUID   0xB2C2
+#define ROBOROACH_CHAR_STATUS_UUID           0xB2C3  //notifies train start/finish/rejection
+#define ROBOROACH_CHAR_EVENT_STATS_UUID      0xB2C4  //ROBOROACH_EVENT_STATS builds only
+#define ROBOROACH_CHAR_LATENCY_UUID          0xB2C5  //ROBOROACH_LATENCY_STATS builds only
+#define ROBOROACH_CHAR_LIVE_UPDATE_UUID      0xB2C6  //1 = writes apply at the next pulse
+#define ROBOROACH_CHAR_PRESET_UPLOAD_UUID    0xB2C7  //slot, then a Stimulation Config value
+#define ROBOROACH_CHAR_ACTIVE_PRESET_UUID    0xB2C8  //write a slot to load its parameters
+
+// Command policy: what a stimulate write does while a train is running
+#define ROBOROACH_POLICY_DROP                0  //ignore it (default)
+#define ROBOROACH_POLICY_FIFO                1  //queue it, ignored when the queue is full
+#define ROBOROACH_POLICY_LATEST              2  //replace anything queued
+#define ROBOROACH_POLICY_PREEMPT             3  //other side: stop and switch now, same side: latest
+
+// Stimulation Config characteristic, version 1 layout (multi-byte fields little endian)
+#define ROBOROACH_CONFIG_VERSION             1
+#define ROBOROACH_CONFIG_LEN                 16
+#define ROBOROACH_CONFIG_OFS_VERSION         0
+#define ROBOROACH_CONFIG_OFS_FREQUENCY       1
+#define ROBOROACH_CONFIG_OFS_PULSE_WIDTH     2
+#define ROBOROACH_CONFIG_OFS_DURATION        3
+#define ROBOROACH_CONFIG_OFS_RANDOM_MODE     4
+#define ROBOROACH_CONFIG_OFS_GAIN            5
+#define ROBOROACH_CONFIG_OFS_FREQ_MIN        6
+#define ROBOROACH_CONFIG_OFS_FREQ_MAX        7
+#define ROBOROACH_CONFIG_OFS_PW_MIN          8
+#define ROBOROACH_CONFIG_OFS_PW_MAX          9
+#define ROBOROACH_CONFIG_OFS_GAIN_MIN        10
+#define ROBOROACH_CONFIG_OFS_GAIN_MAX        11
+#define ROBOROACH_CONFIG_OFS_PULSE_WIDTH_US  12
+#define ROBOROACH_CONFIG_OFS_PERIOD_US       14
+
+// Preset slots: full parameter sets in SNV, uploaded once and selected by
+// writing the slot number to the Active Preset characteristic. Reading it
+// gives the slot last loaded, or ROBOROACH_PRESET_NONE once a parameter
+// was written since.
+#define ROBOROACH_NUM_PRESETS                4
+#define ROBOROACH_PRESET_NONE                0xFF
+#define ROBOROACH_PRESET_UPLOAD_LEN          ( 1 + ROBOROACH_CONFIG_LEN )
+
+// Status beacon: manufacturer specific data in the advertisement, so a
+// scan shows the state of every roach without connecting. Company ID
+// 0xFFFF is the one the Bluetooth SIG leaves for tests and internal use.
+#define ROBOROACH_BEACON_COMPANY_ID          0xFFFF
+#define ROBOROACH_BEACON_LEN                 8   //after the company ID
+#define ROBOROACH_BEACON_OFS_BATTERY         0   //percent
+#define ROBOROACH_BEACON_OFS_FW_MAJOR        1
+#define ROBOROACH_BEACON_OFS_FW_MINOR        2
+#define ROBOROACH_BEACON_OFS_HARDWARE        3   //ROBOROACH_HARDWARE_REV
+#define ROBOROACH_BEACON_OFS_SHORT_ID        4   //low two bytes of the device address
+#define ROBOROACH_BEACON_OFS_STATE           6   //ROBOROACH_BEACON_STATE_* bits
+#define ROBOROACH_BEACON_OFS_PRESET          7   //Active Preset
+#define ROBOROACH_BEACON_STATE_STIMULATING   0x01
+
+// Stimulation Status characteristic: sequence, event, side (1 = left), queued commands
+#define ROBOROACH_STATUS_LEN                 4
+#define ROBOROACH_STATUS_IDLE                0
+#define ROBOROACH_STATUS_STARTED             1
+#define ROBOROACH_STATUS_FINISHED            2
+#define ROBOROACH_STATUS_REJECTED            3
+#define ROBOROACH_STATUS_QUEUED              4
+
+// Event Statistics characteristic: per task event, in dispatch order, the
+// event bit, handler runs, max and average run time in us (little endian).
+// Any write clears the counters.
+#define ROBOROACH_EVENT_STATS_RECORD_LEN     8
+
+// Latency Statistics characteristic: stimulate write to first antenna edge.
+// Records 1-3 are the stages (write to task, task to train setup, setup to
+// first edge), record 4 the whole path. Each: record number, count, min,
+// max and mean in us, then ROBOROACH_LATENCY_BINS counts of
+// ROBOROACH_LATENCY_BIN_US wide bins, the last one open ended (little
+// endian). Any write clears the statistics.
+#define ROBOROACH_LATENCY_BINS               8
+#define ROBOROACH_LATENCY_BIN_US             500
+#define ROBOROACH_LATENCY_RECORD_LEN         ( 9 + 2 * ROBOROACH_LATENCY_BINS )
+
+// Stimulate commands held while a train is running
+#define ROBOROACH_STIM_QUEUE_LEN             4
+
+// Stimulate commands received but not yet taken by the application
+#define ROBOROACH_COMMAND_INBOX_LEN          4
   
 #define ROBOROACH_FIRMWARE_VERSION               "0.3"
+#define ROBOROACH_FIRMWARE_VERSION_MAJOR         0     //same version, for the status beacon
+#define ROBOROACH_FIRMWARE_VERSION_MINOR         3
 //#define ROBOROACH_V10A
 //#define ROBOROACH_V10B
 //#define ROBOROACH_V10G
@@ -63,6 +159,7 @@ extern "C"
   
 #if defined ( ROBOROACH_V10A )
  #define ROBOROACH_HARDWARE_VERSION               "1.0A" 
+ #define ROBOROACH_HARDWARE_REV                   0x01  //status beacon code
  #define ROBOROACH_HAS_CONNECTION_LEDS            0 
  #define ROBOROACH_PIO_LED_LEFT                   P0_7
  #define ROBOROACH_PIO_LED_RIGHT                  P0_6
@@ -74,6 +171,7 @@ extern "C"
   
   #if defined ( ROBOROACH_V10B )
  #define ROBOROACH_HARDWARE_VERSION               "1.0B" 
+ #define ROBOROACH_HARDWARE_REV                   0x02
  #define ROBOROACH_HAS_CONNECTION_LEDS            0 
  #define ROBOROACH_PIO_LED_LEFT                   P1_0
  #define ROBOROACH_PIO_LED_RIGHT                  P1_1
@@ -85,6 +183,7 @@ extern "C"
   
 #if defined ( ROBOROACH_V10G )
  #define ROBOROACH_HARDWARE_VERSION               "1.0G" 
+ #define ROBOROACH_HARDWARE_REV                   0x03
  #define ROBOROACH_HAS_CONNECTION_LEDS            1 
  #define ROBOROACH_PIO_LED_LEFT                   P0_5
  #define ROBOROACH_PIO_LED_RIGHT                  P0_4
@@ -96,21 +195,27 @@ extern "C"
   
 #if defined ( ROBODEV )      //[wjr]--> Not 100% mapped to DK yet
  #define ROBOROACH_HARDWARE_VERSION               "EVAL" 
+ #define ROBOROACH_HARDWARE_REV                   0xFE
  #define ROBOROACH_HAS_CONNECTION_LEDS            1 
  #define ROBOROACH_PIO_LED_LEFT                   P1_0 // LED
  #define ROBOROACH_PIO_LED_RIGHT                  P1_7  
  #define ROBOROACH_PIO_ANTENNA_LEFT               P1_1  
  #define ROBOROACH_PIO_ANTENNA_RIGHT              P0_1 
+ #define ROBOROACH_ANTENNA_LEFT_T1_CHANNEL        1    // P1_1
+ #define ROBOROACH_ANTENNA_RIGHT_T1_CHANNEL       0    // P0_1 has no Timer 1 output
  #define ROBOROACH_PIO_LED_CONNECTION_1           P1_5   
  #define ROBOROACH_PIO_LED_CONNECTION_2           P1_4  
  #define ROBOROACH_WAKE_UP_BUTTON                 P0_6 //[wjr] still requires breadboard button
 #else
  #define ROBOROACH_HARDWARE_VERSION               "1.21" //1.1B
+ #define ROBOROACH_HARDWARE_REV                   0x04
  #define ROBOROACH_HAS_CONNECTION_LEDS            1 
  #define ROBOROACH_PIO_LED_LEFT                   P1_6  //Left turn - Lights up Right
  #define ROBOROACH_PIO_LED_RIGHT                  P1_7  //Right turn - Lights up Left
  #define ROBOROACH_PIO_ANTENNA_LEFT               P1_1  
  #define ROBOROACH_PIO_ANTENNA_RIGHT              P1_0  
+ #define ROBOROACH_ANTENNA_LEFT_T1_CHANNEL        1    // P1_1
+ #define ROBOROACH_ANTENNA_RIGHT_T1_CHANNEL       2    // P1_0
  #define ROBOROACH_PIO_LED_CONNECTION_1           P1_5   
  #define ROBOROACH_PIO_LED_CONNECTION_2           P1_4  //Left?
  #define ROBOROACH_WAKE_UP_BUTTON                 P0_6 
@@ -123,23 +228,55 @@ extern "C"
 // What happens when we connect? 
 #define BYB_ADV_PULSE_PERIOD                         1000  
 #define BYB_ADV_PULSE_WIDTH                            20  
-#define BYB_CONNECT_PULSE_PERIOD                        5  
-#define BYB_CONNECT_PULSE_WIDTH                         1 
+
+// Advertising interval after a wake up or a lost link (units of 625us):
+// fast while someone is likely scanning for it, slower the longer nobody
+// connects, until BYB_DISCONNECT_PERIOD_B4_SLEEP ends it. The times are
+// counted in advertising blinks (BYB_ADV_PULSE_PERIOD).
+#define BYB_ADV_FAST_INTERVAL                          32 //20ms
+#define BYB_ADV_FAST_PERIOD                          5000
+#define BYB_ADV_MEDIUM_INTERVAL                       244 //152.5ms
+#define BYB_ADV_MEDIUM_PERIOD                       15000 //until 20s
+#define BYB_ADV_SLOW_INTERVAL                        1636 //1022.5ms, until sleep
+#define BYB_CONNECT_LED_PERIOD                       2000 //connected: flash every 2s
+#define BYB_CONNECT_LED_WIDTH                          20 
   
 #define BYB_BATTERY_CHECK_PERIOD                    10000 //Every 10s
 
 #define POWER_SAVING  1  
+
+// Drivers that need the 32 MHz clock kept running (roboRoachApp_HoldPower)
+#define ROBOROACH_POWER_PULSE                        0x01 //Timer 1 train
+#define ROBOROACH_POWER_POT                          0x02 //digipot SPI transfer
 #define BYB_DISCONNECT_PERIOD_B4_SLEEP              30000 //Every 30s   
+
+// Stimulation parameters kept in SNV (Stimulation Config layout). Writes
+// are saved once none came for BYB_PARAMS_SAVE_DELAY ms, or before sleep.
+#define ROBOROACH_NV_PARAMS                          BLE_NVID_CUST_START
+#define ROBOROACH_NV_PRESET_FIRST                    ( BLE_NVID_CUST_START + 1 ) //one per slot
+#define BYB_PARAMS_SAVE_DELAY                        5000
+
+// Connection parameters while steering and when parked (intervals in 1.25ms,
+// timeouts in 10ms units). Idle is requested after no command for a while.
+#define BYB_STEERING_MIN_CONN_INTERVAL                  6 //7.5ms
+#define BYB_STEERING_MAX_CONN_INTERVAL                 12 //15ms
+#define BYB_STEERING_SLAVE_LATENCY                      0
+#define BYB_STEERING_CONN_TIMEOUT                     200 //2s
+#define BYB_IDLE_MIN_CONN_INTERVAL                     80 //100ms
+#define BYB_IDLE_MAX_CONN_INTERVAL                    160 //200ms
+#define BYB_IDLE_SLAVE_LATENCY                          4
+#define BYB_IDLE_CONN_TIMEOUT                         600 //6s
+#define BYB_CONN_IDLE_TIMEOUT                       10000 //10s without commands
   
 // RoboRoach Events  
 #define BYB_START_DEVICE_EVT                        0x0001
-#define BYB_TURN_OFF_STIM_EVT                       0x0002
+#define BYB_CONN_IDLE_EVT                           0x0002
 #define BYB_BATTERY_CHECK_EVT                       0x0004
-#define BYB_ADV_IN_CONNECTION_EVT                   0x0008 //[wjr: not being used currently]
-#define BYB_ADV_PULSE_ON_EVT                        0x0010 
-#define BYB_ADV_PULSE_OFF_EVT                       0x0020 
-#define BYB_CONNECT_PULSE_ON_EVT                    0x0040
-#define BYB_CONNECT_PULSE_OFF_EVT                   0x0080
+#define BYB_STIMULATE_REFILL_EVT                    0x0008
+#define BYB_ADV_PULSE_EVT                           0x0010 
+#define BYB_POT_DONE_EVT                            0x0020
+#define BYB_CONNECT_LED_EVT                         0x0040
+#define BYB_PARAMS_SAVE_EVT                         0x0080
 #define BYB_STIMULATE_LEFT_EVT                      0x0100
 #define BYB_STIMULATE_RIGHT_EVT                     0x0200
 #define BYB_STIMULATE_PULSE_ON_EVT                  0x0400
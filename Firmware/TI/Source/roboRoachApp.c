@@ -20,6 +20,7 @@
 #include "hal_key.h"
 #include "hal_lcd.h"
 #include "hal_sleep.h" 
+#include "osal_snv.h"
 
 #include "gatt.h"
 
@@ -33,6 +34,10 @@
 #include "roboRoach.h"
 
 #include "MCP4000.h"
+#include "roboRoachPulse.h"
+#include "roboRoachLed.h"
+#include "roboRoachTimer.h"
+#include "roboRoachLatency.h"
 
 #if defined ( PLUS_BROADCASTER )
   #include "peripheralBroadcaster.h"
@@ -59,9 +64,6 @@
  */
 
 
-// What is the advertising interval when device is discoverable (units of 625us, 160=100ms)
-#define DEFAULT_ADVERTISING_INTERVAL          160 
-
 // Whether to enable automatic parameter update request when a connection is formed
 #define DEFAULT_ENABLE_UPDATE_REQUEST         FALSE
 
@@ -86,11 +88,19 @@
 // Supervision timeout value (units of 10ms, 1000=10s) if automatic parameter update request is enabled
 #define DEFAULT_DESIRED_CONN_TIMEOUT          1000
 
+// Connection parameter sets requested by the application (see roboRoach.h)
+#define CONN_PROFILE_NONE                     0   // whatever the central chose
+#define CONN_PROFILE_STEERING                 1
+#define CONN_PROFILE_IDLE                     2
+
 // Company Identifier: Texas Instruments Inc. (13)
 #define TI_COMPANY_ID                         0x000D
 
 #define INVALID_CONNHANDLE                    0xFFFF
 
+// Where the status beacon fields start in advertData
+#define ADVERT_BEACON_OFS                     11
+
 // Length of bd addr as a string
 #define B_ADDR_STR_LEN                        15
 
@@ -102,12 +112,36 @@
  * TYPEDEFS
  */
 
+// Task event handler, run for one BYB_*_EVT bit (or group of bits)
+typedef void (*roboRoachEventHandler_t)( void );
+
+typedef struct
+{
+  uint16                  event;
+  roboRoachEventHandler_t pfnHandler;
+} roboRoachEvent_t;
+
+#if defined ( ROBOROACH_EVENT_STATS )
+typedef struct
+{
+  uint16 count;
+  uint16 max;
+  uint32 total;
+} eventStats_t;
+#endif
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
 
 bool isConnected = FALSE;
 
+// Connection parameter set last requested from the central
+static uint8 connProfile = CONN_PROFILE_NONE;
+
+// Drivers currently holding the 32 MHz clock (ROBOROACH_POWER_*)
+static uint8 powerHolders = 0;
+
 /*********************************************************************
  * EXTERNAL VARIABLES
  */
@@ -120,27 +154,54 @@ bool isConnected = FALSE;
  * LOCAL VARIABLES
  */
 
-uint8   connectPulseCount = 0;   
 uint8   stimulationPulseCount = 0;   
 uint16  stimulationCurrentDuration = 0;   
 uint8   stimulationInProgress = 0;   
 uint8   stimulationIsLeft = 0;
-uint16  stimulationPeriod = 0;
-uint8   stimulationPulseWidth = 0;
-uint8   stimulationDurationIn5msIncrements = 0;
-uint8   stimulationRandomMode = 0;
-uint8   stimulationGain = 0; 
-uint8   stimulationFreqMin = 0;
-uint8   stimulationFreqMax = 0;  
-uint8   stimulationPWmin = 0;
-uint8   stimulationPWmax = 0;
-uint8   stimulationGainMin = 0;
-uint8   stimulationGainMax = 0;
+uint32  stimulationStartTime = 0;     //osal_GetSystemClock() at the first pulse
+uint16  stimulationPeriodMin = 0;     //Random mode: shortest period (ms)
+uint16  stimulationPeriodSpan = 0;    //Random mode: period range (ms), 0 = fixed
+uint8   stimulationPWMin = 0;         //Random mode: shortest pulse width (ms)
+uint8   stimulationPWSpan = 0;        //Random mode: pulse width range (ms), 0 = fixed
+uint8   stimulationGainMin = 0;       //Random mode: lowest gain (%)
+uint8   stimulationGainSpan = 0;      //Random mode: gain range (%), 0 = fixed
+
+// Where the train runs (ROBOROACH_PULSE_ON_*), and whether its next edge
+// waits for the gain to reach the digipot (BYB_POT_DONE_EVT). An OSAL pulse
+// waits in stimulationStep.
+static uint8       stimulationMode = ROBOROACH_PULSE_ON_OSAL;
+static bool        stimulationGainWait = FALSE;
+static pulseStep_t stimulationStep;
+
+// Stimulation parameters, double buffered. The train runs from the active
+// copy; parameter writes refill the pending one, and the two are swapped
+// when the next train starts. Both are only touched from the task.
+static roboRoachParams_t stimulationParams[2];
+static roboRoachParams_t *pStimActive = &stimulationParams[0];
+static roboRoachParams_t *pStimPending = &stimulationParams[1];
+static bool stimulationParamsPending = FALSE;
+
+// Stimulation parameters as last saved to SNV (Stimulation Config layout),
+// and whether a write came in since
+static uint8 paramsSaved[ROBOROACH_CONFIG_LEN];
+static bool paramsUnsaved = FALSE;
+
+// Stimulate commands received during a train (1 = left), oldest first
+static uint8 stimulationQueue[ROBOROACH_STIM_QUEUE_LEN];
+static uint8 stimulationQueueHead = 0;
+static uint8 stimulationQueueCount = 0;
    
 static uint8 roboRoachApp_TaskID;   // Task ID for internal task/event processing
 
 static gaprole_States_t gapProfileState = GAPROLE_INIT;
 
+// Advertising blinks since advertising (re)started at the fast interval,
+// whether it is only being restarted for a new interval, and whether the
+// blink is lit
+static uint8 advertBlinks = 0;
+static bool advertRestart = FALSE;
+static bool advertBlinkLit = FALSE;
+
 // GAP - SCAN RSP data (max size = 31 bytes)
 static uint8 scanRspData[] =
 {
@@ -189,6 +250,19 @@ static uint8 advertData[] =
   LO_UINT16( ROBOROACH_SERV_UUID ),
   HI_UINT16( ROBOROACH_SERV_UUID ),
 
+  // status beacon, kept up to date by updateRoboRoachBeacon()
+  0x03 + ROBOROACH_BEACON_LEN,   // length of this data
+  GAP_ADTYPE_MANUFACTURER_SPECIFIC,
+  LO_UINT16( ROBOROACH_BEACON_COMPANY_ID ),
+  HI_UINT16( ROBOROACH_BEACON_COMPANY_ID ),
+  0,                                  // battery, measured when advertising starts
+  ROBOROACH_FIRMWARE_VERSION_MAJOR,
+  ROBOROACH_FIRMWARE_VERSION_MINOR,
+  ROBOROACH_HARDWARE_REV,
+  0,                                  // short ID, from the device address
+  0,
+  0,                                  // state
+  ROBOROACH_PRESET_NONE,
 };
 
 // GAP GATT Attributes
@@ -201,7 +275,80 @@ static void roboRoachApp_ProcessOSALMsg( osal_event_hdr_t *pMsg );
 static void peripheralStateNotificationCB( gaprole_States_t newState );
 static void roboRoachProfileChangeCB( uint8 paramID );
 static void ifZero(void);
-bool areEqual(uint8 minVal, uint8 maxVal);
+static void loadRoboRoachParams( void );
+static void swapRoboRoachParams( void );
+static void retuneRoboRoachStimulation( void );
+static void restoreRoboRoachParams( void );
+static void updateRoboRoachBeacon( void );
+static void resetRoboRoachAdvertising( void );
+static void dropRoboRoachLink( void );
+static void setRoboRoachAdvertInterval( uint16 interval );
+static void saveRoboRoachParams( void );
+static void fillRoboRoachSchedule( void );
+static uint8 requestRoboRoachStimulation( uint8 isLeft );
+static void stopRoboRoachStimulation( void );
+static void queueRoboRoachStimulation( uint8 isLeft );
+static void requestConnectionProfile( uint8 profile );
+static void takeRoboRoachCommands( void );
+
+static void roboRoachApp_HandleMsg( void );
+static void roboRoachApp_HandleStartDevice( void );
+static void roboRoachApp_HandleBatteryCheck( void );
+static void roboRoachApp_HandleSleep( void );
+static void roboRoachApp_HandleWakeUp( void );
+static void roboRoachApp_HandleAdvPulse( void );
+static void roboRoachApp_HandleStimulate( void );
+static void roboRoachApp_HandleConnIdle( void );
+static void roboRoachApp_HandleRefill( void );
+static void roboRoachApp_HandlePotDone( void );
+static void roboRoachApp_HandleParamsSave( void );
+static void roboRoachApp_PotDone( void );
+static bool roboRoachApp_WriteGain( uint8 gain );
+static void roboRoachApp_HandlePulseOn( void );
+static void roboRoachApp_PulseEdge( void );
+static void roboRoachApp_PrepareGain( void );
+static void roboRoachApp_HandlePulseOff( void );
+static void roboRoachApp_HandleFinished( void );
+
+#if defined ( ROBOROACH_EVENT_STATS )
+static uint32 eventStatsNow( void );
+static void eventStatsRecord( uint8 index, uint32 ticks );
+static void eventStatsReset( void );
+static uint16 eventStatsUs( uint32 ticks );
+static uint8 eventStatsRead( uint8 *pValue, uint16 offset, uint8 maxLen );
+#endif
+
+/*********************************************************************
+ * EVENT DISPATCH
+ */
+
+// Task events in priority order: the stimulation edges come first so a
+// pulse is never held up behind housekeeping
+static CONST roboRoachEvent_t roboRoachEvents[] =
+{
+  { BYB_STIMULATE_PULSE_OFF_EVT,                        roboRoachApp_HandlePulseOff },
+  { BYB_STIMULATE_PULSE_ON_EVT,                         roboRoachApp_HandlePulseOn },
+  { BYB_POT_DONE_EVT,                                   roboRoachApp_HandlePotDone },
+  { BYB_STIMULATE_FINISHED_EVT,                         roboRoachApp_HandleFinished },
+  { BYB_STIMULATE_REFILL_EVT,                           roboRoachApp_HandleRefill },
+  { SYS_EVENT_MSG,                                      roboRoachApp_HandleMsg },
+  { BYB_STIMULATE_LEFT_EVT | BYB_STIMULATE_RIGHT_EVT,   roboRoachApp_HandleStimulate },
+  { BYB_CONN_IDLE_EVT,                                  roboRoachApp_HandleConnIdle },
+  { BYB_ADV_PULSE_EVT,                                  roboRoachApp_HandleAdvPulse },
+  { BYB_CONNECT_LED_EVT,                                RoboRoachLed_ProcessFlash },
+  { BYB_BATTERY_CHECK_EVT,                              roboRoachApp_HandleBatteryCheck },
+  { BYB_WAKE_UP_EVT,                                    roboRoachApp_HandleWakeUp },
+  { BYB_PARAMS_SAVE_EVT,                                roboRoachApp_HandleParamsSave },
+  { BYB_SLEEP_EVT,                                      roboRoachApp_HandleSleep },
+  { BYB_START_DEVICE_EVT,                               roboRoachApp_HandleStartDevice },
+};
+
+#define ROBOROACH_NUM_EVENTS    ( sizeof( roboRoachEvents ) / sizeof( roboRoachEvents[0] ) )
+
+#if defined ( ROBOROACH_EVENT_STATS )
+// Handler runs per table entry, times in sleep timer ticks
+static eventStats_t eventStats[ROBOROACH_NUM_EVENTS];
+#endif
 
 #if defined( CC2540_MINIDK )
 //static void roboRoachApp_HandleKeys( uint8 shift, uint8 keys );
@@ -229,7 +376,12 @@ static gapBondCBs_t roboRoachApp_BondMgrCBs =
 // Simple GATT Profile Callbacks
 static roboRoachProfileCBs_t roboRoachApp_RoboRoachProfileCBs =
 {
-  roboRoachProfileChangeCB    // Charactersitic value change callback
+  roboRoachProfileChangeCB,   // Charactersitic value change callback
+#if defined ( ROBOROACH_EVENT_STATS )
+  eventStatsRead              // Event Statistics characteristic read
+#else
+  NULL
+#endif
 };
 
 /*********************************************************************
@@ -292,15 +444,8 @@ void RoboRoachPeripheral_Init( uint8 task_id )
   // Set the GAP Characteristics
   GGS_SetParameter( GGS_DEVICE_NAME_ATT, GAP_DEVICE_NAME_LEN, attDeviceName );
 
-  // Set advertising interval
-  {
-    uint16 advInt = DEFAULT_ADVERTISING_INTERVAL;
-
-    GAP_SetParamValue( TGAP_LIM_DISC_ADV_INT_MIN, advInt );
-    GAP_SetParamValue( TGAP_LIM_DISC_ADV_INT_MAX, advInt );
-    GAP_SetParamValue( TGAP_GEN_DISC_ADV_INT_MIN, advInt );
-    GAP_SetParamValue( TGAP_GEN_DISC_ADV_INT_MAX, advInt );
-  }
+  // Set advertising interval, fast until nobody connected for a while
+  resetRoboRoachAdvertising();
 
   //[GJG] - What is this?  
   // Setup the GAP Bond Manager
@@ -353,6 +498,12 @@ void RoboRoachPeripheral_Init( uint8 task_id )
     RoboRoachProfile_SetParameter( ROBOROACH_GAIN_MIN, sizeof ( uint8 ), &charValue10 );  
     RoboRoachProfile_SetParameter( ROBOROACH_GAIN_MAX, sizeof ( uint8 ), &charValue11 );  
     
+    //The values saved before the last power down replace the defaults
+    restoreRoboRoachParams();
+
+    //The first train runs with these
+    loadRoboRoachParams();
+
     DevInfo_SetParameter(DEVINFO_MANUFACTURER_NAME, 16, "Backyard Brains");
     
   }
@@ -385,6 +536,17 @@ void RoboRoachPeripheral_Init( uint8 task_id )
   
   //initialize SPI for digipot 
   potInit();
+  potSetDoneCB( roboRoachApp_PotDone );
+  
+  //initialize Timer 1 for the stimulation pulse trains
+  RoboRoachPulse_Init( roboRoachApp_TaskID, BYB_STIMULATE_FINISHED_EVT,
+                       BYB_STIMULATE_REFILL_EVT );
+  
+  //track the timers of this task so they can be cancelled before sleep
+  RoboRoachTimer_Init( roboRoachApp_TaskID );
+  
+  //connection indicator off, flashes timed by this task
+  RoboRoachLed_Init( BYB_CONNECT_LED_EVT );
   
   //initialize power management mode 
   osal_pwrmgr_init();
@@ -421,346 +583,927 @@ void RoboRoachPeripheral_Init( uint8 task_id )
  */
 uint16 RoboRoachPeripheral_ProcessEvent( uint8 task_id, uint16 events )
 {
+  uint8 i;
 
   VOID task_id; // OSAL required parameter that isn't used in this function
 
-  if ( events & SYS_EVENT_MSG )
+  // One event per call, highest priority first; OSAL calls back for the rest
+  for ( i = 0; i < ROBOROACH_NUM_EVENTS; i++ )
   {
-    uint8 *pMsg;
-
-    if ( (pMsg = osal_msg_receive( roboRoachApp_TaskID )) != NULL )
+    if ( events & roboRoachEvents[i].event )
     {
-      roboRoachApp_ProcessOSALMsg( (osal_event_hdr_t *)pMsg );
+#if defined ( ROBOROACH_EVENT_STATS )
+      uint32 start = eventStatsNow();
 
-      // Release the OSAL message
-      VOID osal_msg_deallocate( pMsg );
+      roboRoachEvents[i].pfnHandler();
+      eventStatsRecord( i, eventStatsNow() - start );
+#else
+      roboRoachEvents[i].pfnHandler();
+#endif
+      return ( events & ~roboRoachEvents[i].event );
     }
-
-    // return unprocessed events
-    return (events ^ SYS_EVENT_MSG);
   }
-  
-  if ( events & BYB_START_DEVICE_EVT )
+
+  // Discard unknown events
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      roboRoachApp_HandleMsg
+ *
+ * @brief   SYS_EVENT_MSG: process one OSAL message. OSAL sets the event
+ *          again while more messages are waiting.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void roboRoachApp_HandleMsg( void )
+{
+  uint8 *pMsg;
+
+  if ( (pMsg = osal_msg_receive( roboRoachApp_TaskID )) != NULL )
   {
-    // Start the Device
-    VOID GAPRole_StartDevice( &roboRoachApp_PeripheralCBs );
+    roboRoachApp_ProcessOSALMsg( (osal_event_hdr_t *)pMsg );
 
-    // Start Bond Manager
-    VOID GAPBondMgr_Register( &roboRoachApp_BondMgrCBs );
-    
-    //Start timer which sets Sleep event if not connected after BYB_DISCONNECT_PERIOD_B4_SLEEP ms
-    osal_start_timerEx( roboRoachApp_TaskID, BYB_SLEEP_EVT, BYB_DISCONNECT_PERIOD_B4_SLEEP );
-    
-    return ( events ^ BYB_START_DEVICE_EVT );
+    // Release the OSAL message
+    VOID osal_msg_deallocate( pMsg );
   }
+}
+
+/*********************************************************************
+ * @fn      roboRoachApp_HandleStartDevice
+ *
+ * @brief   BYB_START_DEVICE_EVT: start the GAP role and bond manager.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void roboRoachApp_HandleStartDevice( void )
+{
+  // Start the Device
+  VOID GAPRole_StartDevice( &roboRoachApp_PeripheralCBs );
+
+  // Start Bond Manager
+  VOID GAPBondMgr_Register( &roboRoachApp_BondMgrCBs );
   
-  if ( events & BYB_BATTERY_CHECK_EVT )
+  //Start timer which sets Sleep event if not connected after BYB_DISCONNECT_PERIOD_B4_SLEEP ms
+  RoboRoachTimer_Start( BYB_SLEEP_EVT, BYB_DISCONNECT_PERIOD_B4_SLEEP );
+}
+
+/*********************************************************************
+ * @fn      roboRoachApp_HandleBatteryCheck
+ *
+ * @brief   BYB_BATTERY_CHECK_EVT: measure the battery level.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void roboRoachApp_HandleBatteryCheck( void )
+{
+  // Restart timer
+  if ( BYB_BATTERY_CHECK_PERIOD )
   {
-    // Restart timer
-    if ( BYB_BATTERY_CHECK_PERIOD )
-    {
-      osal_start_timerEx( roboRoachApp_TaskID, BYB_BATTERY_CHECK_EVT, BYB_BATTERY_CHECK_PERIOD );
-    }
+    RoboRoachTimer_Start( BYB_BATTERY_CHECK_EVT, BYB_BATTERY_CHECK_PERIOD );
+  }
 
-    // perform battery level check
-    Batt_MeasLevel( );
+  // perform battery level check
+  Batt_MeasLevel( );
+  updateRoboRoachBeacon();
+
+     #if (defined HAL_LCD) && (HAL_LCD == TRUE)
+       HalLcdWriteString( "battery Check",  HAL_LCD_LINE_2 );
+     #endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
+}
 
-       #if (defined HAL_LCD) && (HAL_LCD == TRUE)
-         HalLcdWriteString( "battery Check",  HAL_LCD_LINE_2 );
-       #endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
-    
-    return (events ^ BYB_BATTERY_CHECK_EVT);
-  }
-  
-  // Write Gain value to the digital potentiometer
-  Gain_SetLevel( stimulationGain );  
-    
 /**************************
 * Sleep RoboRoach, sleep...
 *     1) put the roboroach to sleep after # ms being disconnected
 *     2) Wake up button will enable advertising mode for # ms
 ****************************/
 //Put it to sleep! [wjr]--> PM2 or PM3?
-  if ( events & BYB_SLEEP_EVT )
+static void roboRoachApp_HandleSleep( void )
+{
+  // don't put to sleep if connected
+  if (gapProfileState == GAPROLE_CONNECTED)
   {
-    // don't put to sleep if connected
+    return;
+  }
+    
+  // turn off advertising, for good if it was being restarted
+  uint8 advertising_enabill = FALSE;
+  advertRestart = FALSE;
+  GAPRole_SetParameter( GAPROLE_ADVERT_ENABLED, sizeof( uint8 ), &advertising_enabill );
+  
+  // a parameter write still waiting to be saved goes to flash now
+  saveRoboRoachParams();
+
+  // stop every timer of this task (battery check, advertising blink, sleep,
+  // ...) and drop events they already set. The stack's own timers belong to
+  // the stack and stop with advertising.
+  RoboRoachTimer_CancelAll();
+  ROBOROACH_PIO_LED_LEFT = 0;
+  ROBOROACH_PIO_LED_RIGHT = 0;
+  
+  // sets the processor/system into sleep
+  osal_pwrmgr_powerconserve();  
+}
+
+// Button pressed: Interrupt subroutine
+static void roboRoachApp_HandleWakeUp( void )
+{
+    //If connected, don't start timer for sleep event
     if (gapProfileState == GAPROLE_CONNECTED)
     {
-      return (events ^ BYB_SLEEP_EVT);
+      return;
     }
-      
-    // turn off advertising
-    uint8 advertising_enabill = FALSE;
-    GAPRole_SetParameter( GAPROLE_ADVERT_ENABLED, sizeof( uint8 ), &advertising_enabill );
-    
-    // stop timers that may be running
-    osal_stop_timerEx( 0x00, 0x0100 ); //stop LL ? timer
-    osal_stop_timerEx( 0x0B, 0x0004 ); //stop RR battery check timer
-    osal_stop_timerEx( 0x0B, 0x2000 ); //stop RR sleep evt timer
-    osal_stop_timerEx( 0x00, 0x0000 ); //stop LL ? timer
-    osal_stop_timerEx( 0x00, 0x0020 ); //stop LL ? timer 
-    osal_stop_timerEx( 0x0B, 0x0010 ); //stop RR ADV Pulse On timer
-    
-    //[wjr!!!!] for TESTING: 
-    //osalFindTimer( roboRoachApp_TaskID, 0x0008 );
-        //looks for a timer for an event we don't use = see all active timers!
-        //not sure if stopping them really helps, maybe need to delete. something might still be running...
-        //-->another idea: hack the findTimer function to seek and destroy all remaining timers?
-    
-    // sets the processor/system into sleep
-    osal_pwrmgr_powerconserve();  
     
-    return (events ^ BYB_SLEEP_EVT);
-  }
+    else //RR is sleeping, wake it up
+    {
+      //Turn on advertising, fast to be found at once. If it was still
+      //on, it restarts at the fast interval by itself.
+      uint8 advertising_enable = TRUE;
+      bool advertising = ( gapProfileState == GAPROLE_ADVERTISING );
 
-  // Button pressed: Interrupt subroutine
-  if ( events & BYB_WAKE_UP_EVT )
-  {
-      //If connected, don't start timer for sleep event
-      if (gapProfileState == GAPROLE_CONNECTED)
-      {
-        return (events ^ BYB_WAKE_UP_EVT);
-      }
-      
-      else //RR is sleeping, wake it up
+      resetRoboRoachAdvertising();
+      if ( !advertising )
       {
-        //Turn on advertising 
-        uint8 advertising_enable = TRUE;
         GAPRole_SetParameter( GAPROLE_ADVERT_ENABLED, sizeof( uint8 ), &advertising_enable );
-    
-        // start timer to go to sleep if not connected after BYB_DISCONNECT_PERIOD_B4_SLEEP ms
-        osal_start_timerEx( roboRoachApp_TaskID, BYB_SLEEP_EVT, BYB_DISCONNECT_PERIOD_B4_SLEEP );
       }
-    
-    return (events ^ BYB_WAKE_UP_EVT);
-  }
-
-  //Blink LEDs on Advertising - Begin Pulse
-  if ( events & BYB_ADV_PULSE_ON_EVT )
-  {
-    //Load up the next Start Blink
-    if ( gapProfileState != GAPROLE_CONNECTED )
-    {
-      osal_start_timerEx( roboRoachApp_TaskID, BYB_ADV_PULSE_ON_EVT, BYB_ADV_PULSE_PERIOD );
+  
+      // start timer to go to sleep if not connected after BYB_DISCONNECT_PERIOD_B4_SLEEP ms
+      RoboRoachTimer_Start( BYB_SLEEP_EVT, BYB_DISCONNECT_PERIOD_B4_SLEEP );
     }
-    
-    osal_start_timerEx( roboRoachApp_TaskID, BYB_ADV_PULSE_OFF_EVT, BYB_ADV_PULSE_WIDTH );
+}
 
-    ROBOROACH_PIO_LED_LEFT = 1;
-    ROBOROACH_PIO_LED_RIGHT = 1;
-    return (events ^ BYB_ADV_PULSE_ON_EVT);
-  } 
-  
-  //Blink LEDs on Advertising - End Pulse 
-  if ( events & BYB_ADV_PULSE_OFF_EVT )
+//Blink LEDs on Advertising: lit for BYB_ADV_PULSE_WIDTH every BYB_ADV_PULSE_PERIOD
+static void roboRoachApp_HandleAdvPulse( void )
+{
+  uint8 advertising;
+
+  //No more blinks once advertising was turned off for sleep. While it is
+  //restarted for a new interval it is off only until the stack reports it.
+  GAPRole_GetParameter( GAPROLE_ADVERT_ENABLED, &advertising );
+  advertising = ( advertising || advertRestart ) && ( gapProfileState != GAPROLE_CONNECTED );
+
+  //End Pulse, and load up the next Start Blink
+  if ( advertBlinkLit )
   {
+    advertBlinkLit = FALSE;
     ROBOROACH_PIO_LED_LEFT = 0;
     ROBOROACH_PIO_LED_RIGHT = 0;
-    return (events ^ BYB_ADV_PULSE_OFF_EVT);
-  } 
-  
-  //Connection Begin Pulse (Connected) 
-  if ( events & BYB_CONNECT_PULSE_ON_EVT )
-  {
-    if ( isConnected & ROBOROACH_HAS_CONNECTION_LEDS ) 
+    if ( advertising )
     {
-      osal_start_timerEx( roboRoachApp_TaskID, BYB_CONNECT_PULSE_ON_EVT, BYB_CONNECT_PULSE_PERIOD );
-    }     
-    osal_start_timerEx( roboRoachApp_TaskID, BYB_CONNECT_PULSE_OFF_EVT, BYB_CONNECT_PULSE_WIDTH );
-
-    ROBOROACH_PIO_LED_CONNECTION_1 = 1;
-    ROBOROACH_PIO_LED_CONNECTION_2 = 1;
-    return (events ^ BYB_CONNECT_PULSE_ON_EVT);
-  } 
+      RoboRoachTimer_Start( BYB_ADV_PULSE_EVT, BYB_ADV_PULSE_PERIOD - BYB_ADV_PULSE_WIDTH );
+    }
+    return;
+  }
 
-  if ( events & BYB_CONNECT_PULSE_OFF_EVT )
+  //Begin Pulse
+  if ( advertising )
   {
-    ROBOROACH_PIO_LED_CONNECTION_1 = 0;
-    ROBOROACH_PIO_LED_CONNECTION_2 = 0;
-    return (events ^ BYB_CONNECT_PULSE_OFF_EVT);
-  } 
+    //Nobody connected yet: back off to a longer advertising interval
+    if ( advertBlinks == BYB_ADV_FAST_PERIOD / BYB_ADV_PULSE_PERIOD )
+    {
+      setRoboRoachAdvertInterval( BYB_ADV_MEDIUM_INTERVAL );
+    }
+    else if ( advertBlinks == ( BYB_ADV_FAST_PERIOD + BYB_ADV_MEDIUM_PERIOD ) / BYB_ADV_PULSE_PERIOD )
+    {
+      setRoboRoachAdvertInterval( BYB_ADV_SLOW_INTERVAL );
+    }
+    if ( advertBlinks < 0xFF )
+    {
+      advertBlinks++;
+    }
+  }
   
-  if ( events & BYB_STIMULATE_LEFT_EVT )
+  RoboRoachTimer_Start( BYB_ADV_PULSE_EVT, BYB_ADV_PULSE_WIDTH );
+
+  advertBlinkLit = TRUE;
+  ROBOROACH_PIO_LED_LEFT = 1;
+  ROBOROACH_PIO_LED_RIGHT = 1;
+}
+
+/*********************************************************************
+ * @fn      roboRoachApp_HandleStimulate
+ *
+ * @brief   BYB_STIMULATE_LEFT_EVT / _RIGHT_EVT: set by the profile with
+ *          every stimulate write. The commands were normally started from
+ *          the write callback already; what is left is the connection
+ *          interval, which is not changed from inside the stack.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void roboRoachApp_HandleStimulate( void )
+{
+  //Normally already taken from the write callback
+  takeRoboRoachCommands();
+
+  //Short connection interval while steering, until commands stop
+  requestConnectionProfile( CONN_PROFILE_STEERING );
+  RoboRoachTimer_Start( BYB_CONN_IDLE_EVT, BYB_CONN_IDLE_TIMEOUT );
+}
+
+//No commands for a while: slow the connection down to save battery
+static void roboRoachApp_HandleConnIdle( void )
+{
+  requestConnectionProfile( CONN_PROFILE_IDLE );
+}
+
+//Top up the pulse schedule while the train runs
+static void roboRoachApp_HandleRefill( void )
+{
+  if ( stimulationInProgress )
   {
-    //Don't allow multiple stimulations
-    if (stimulationInProgress){
-       return (events ^ BYB_STIMULATE_LEFT_EVT);
-    }
-    stimulationIsLeft = 1;
-    stimulationCurrentDuration = 0;
-    startRoboRoachStimulation();
-    
-    return (events ^ BYB_STIMULATE_LEFT_EVT);
+    fillRoboRoachSchedule();
   }
+}
 
-  if ( events & BYB_STIMULATE_RIGHT_EVT )
+//Digipot writes are out: let the device sleep again, and raise the edge
+//that waited for them
+static void roboRoachApp_HandlePotDone( void )
+{
+  if ( potBusy() )
   {
-    //Don't allow multiple stimulations
-    if (stimulationInProgress){
-       return (events ^  BYB_STIMULATE_RIGHT_EVT);
-    }
-    stimulationIsLeft = 0;
-    stimulationCurrentDuration = 0;
-    startRoboRoachStimulation();
-    
-    return (events ^ BYB_STIMULATE_RIGHT_EVT);
+    return;
   }
+  roboRoachApp_HoldPower( ROBOROACH_POWER_POT, FALSE );
 
-  //Handle the Stimulation Pulses
-  if ( events & BYB_STIMULATE_PULSE_ON_EVT )
+  if ( stimulationGainWait )
   {
-    if (stimulationRandomMode) 
-    {  
-      //ifZero() prevents divison by zero in the 'random mode' calculations
-      //     by setting any of the stim params that are zero to one
-      ifZero();       
-    
-       //areEqual() sets that parameter to non random
-       if(areEqual(stimulationFreqMin, stimulationFreqMax)){
-         stimulationPeriod = 1000/stimulationFreqMin;
-       }
-       else{
-          stimulationPeriod = osal_rand() % ((1000/stimulationFreqMin) - (1000/stimulationFreqMax)) + (1000/stimulationFreqMax);
-       }
-      
-       //areEqual() sets that parameter to non random
-       if(areEqual(stimulationPWmin, stimulationPWmax)){
-         stimulationPulseWidth = stimulationPWmin;
-       }
-       else{
-          stimulationPulseWidth = osal_rand() % (stimulationPWmax - stimulationPWmin) + stimulationPWmin; 
-       }
-      
-       //areEqual() sets that parameter to non random
-       if(areEqual(stimulationGainMin, stimulationGainMax)){
-         stimulationGain = stimulationGainMin;
-       }
-       else{
-          stimulationGain = osal_rand() % ( stimulationGainMax - stimulationGainMin) + stimulationGainMin;
-       }
-     }
-    
-    stimulationCurrentDuration += stimulationPeriod;
-    
-    // Restart timer
-    if ( stimulationCurrentDuration < (uint16)(stimulationDurationIn5msIncrements * 5) ) //Change to check for Duration
+    stimulationGainWait = FALSE;
+    if ( stimulationMode == ROBOROACH_PULSE_ON_TIMER1 )
     {
-      osal_start_timerEx( roboRoachApp_TaskID, BYB_STIMULATE_PULSE_ON_EVT, stimulationPeriod );
-    } else 
-    { 
-      //We are done stimulating.  Shut it down.
-      osal_start_timerEx( roboRoachApp_TaskID, BYB_STIMULATE_FINISHED_EVT, stimulationPulseWidth + 1 );
+      RoboRoachPulse_Go();
+      RoboRoachLatency_Mark( ROBOROACH_LATENCY_EDGE );
     }
-    osal_start_timerEx( roboRoachApp_TaskID, BYB_STIMULATE_PULSE_OFF_EVT, stimulationPulseWidth );
+    else
+    {
+      roboRoachApp_PulseEdge();
+    }
+  }
+}
+
+//No parameter write for a while; keep the values over a power down
+static void roboRoachApp_HandleParamsSave( void )
+{
+  saveRoboRoachParams();
+}
+
+//Digipot write queue drained (USART0 RX interrupt)
+static void roboRoachApp_PotDone( void )
+{
+  osal_set_event( roboRoachApp_TaskID, BYB_POT_DONE_EVT );
+}
 
-    if (stimulationIsLeft) {
-      ROBOROACH_PIO_ANTENNA_LEFT = 1;
-    } else {
-      ROBOROACH_PIO_ANTENNA_RIGHT = 1;
-    }  
-    return (events ^ BYB_STIMULATE_PULSE_ON_EVT);
-  } 
+//Write a gain to the digipot. The SPI finishes in the background and PM2
+//would stop USART0, so the clock is held until BYB_POT_DONE_EVT.
+//Returns TRUE while the writes are going out.
+static bool roboRoachApp_WriteGain( uint8 gain )
+{
+  Gain_SetLevel( gain );
+  if ( potBusy() )
+  {
+    roboRoachApp_HoldPower( ROBOROACH_POWER_POT, TRUE );
+    return ( TRUE );
+  }
+  return ( FALSE );
+}
 
-  if ( events & BYB_STIMULATE_PULSE_OFF_EVT )
+//Handle the Stimulation Pulses (trains that do not run on Timer 1)
+static void roboRoachApp_HandlePulseOn( void )
+{
+  //The next pulse comes precomputed from the schedule
+  if ( !RoboRoachPulse_Fetch( &stimulationStep ) )
   {
-    if (stimulationIsLeft) {
-      ROBOROACH_PIO_ANTENNA_LEFT = 0;
-    } else {
-      ROBOROACH_PIO_ANTENNA_RIGHT = 0;
-    }  
-    return (events ^ BYB_STIMULATE_PULSE_OFF_EVT);
-  } 
+    osal_set_event( roboRoachApp_TaskID, BYB_STIMULATE_FINISHED_EVT );
+    return;
+  }
   
-  if (  events & BYB_STIMULATE_FINISHED_EVT)
+  // Normally written in the gap already; otherwise the edge and its timers
+  // wait for BYB_POT_DONE_EVT, so the pulse keeps its width
+  if ( roboRoachApp_WriteGain( stimulationStep.gain ) )
   {
-    stimulationInProgress = 0;
-    #ifndef ROBOROACH_V10B
-      stimulationIsLeft ? (ROBOROACH_PIO_LED_LEFT = 0) : (ROBOROACH_PIO_LED_RIGHT = 0);
-    #endif
-    return (events ^ BYB_STIMULATE_FINISHED_EVT);
-  } 
+    stimulationGainWait = TRUE;
+    return;
+  }
+  roboRoachApp_PulseEdge();
+}
 
-  // Discard unknown events
-  return 0;
+//Raise the fetched OSAL pulse and arm the timers of its end and the next one
+static void roboRoachApp_PulseEdge( void )
+{
+  // Restart timer
+  if ( RoboRoachPulse_Pending() )
+  {
+    RoboRoachTimer_Start( BYB_STIMULATE_PULSE_ON_EVT, stimulationStep.period );
+  } else 
+  { 
+    //We are done stimulating.  Shut it down.
+    RoboRoachTimer_Start( BYB_STIMULATE_FINISHED_EVT, stimulationStep.width + 1 );
+  }
+  RoboRoachTimer_Start( BYB_STIMULATE_PULSE_OFF_EVT, stimulationStep.width );
+
+  if (stimulationIsLeft) {
+    ROBOROACH_PIO_ANTENNA_LEFT = 1;
+  } else {
+    ROBOROACH_PIO_ANTENNA_RIGHT = 1;
+  }  
+  RoboRoachLatency_Mark( ROBOROACH_LATENCY_EDGE );
 }
 
+static void roboRoachApp_HandlePulseOff( void )
+{
+  if (stimulationIsLeft) {
+    ROBOROACH_PIO_ANTENNA_LEFT = 0;
+  } else {
+    ROBOROACH_PIO_ANTENNA_RIGHT = 0;
+  }  
+  roboRoachApp_PrepareGain();
+}
 
-void startRoboRoachStimulation(){
-  
-  stimulationInProgress = 1;
-  stimulationPulseCount = 0;   
+//Write the gain of the next OSAL pulse while the antenna is low, so its
+//edge does not wait for the SPI
+static void roboRoachApp_PrepareGain( void )
+{
+  uint8 gain;
 
-  RoboRoachProfile_GetParameter( ROBOROACH_STIM_PERIOD, &stimulationPeriod);
-  RoboRoachProfile_GetParameter( ROBOROACH_DURATION,  &stimulationDurationIn5msIncrements);
-  RoboRoachProfile_GetParameter( ROBOROACH_PULSE_WIDTH, &stimulationPulseWidth);
-  RoboRoachProfile_GetParameter( ROBOROACH_RANDOM_MODE, &stimulationRandomMode);
-  RoboRoachProfile_GetParameter( ROBOROACH_GAIN, &stimulationGain); 
-  RoboRoachProfile_GetParameter( ROBOROACH_FREQ_MIN, &stimulationFreqMin); 
-  RoboRoachProfile_GetParameter( ROBOROACH_FREQ_MAX, &stimulationFreqMax);   
-  RoboRoachProfile_GetParameter( ROBOROACH_PW_MIN, &stimulationPWmin); 
-  RoboRoachProfile_GetParameter( ROBOROACH_PW_MAX, &stimulationPWmax);  
-  RoboRoachProfile_GetParameter( ROBOROACH_GAIN_MIN, &stimulationGainMin); 
-  RoboRoachProfile_GetParameter( ROBOROACH_GAIN_MAX, &stimulationGainMax);    
-  
-  //Start Immediately (1ms)
-  osal_start_timerEx( roboRoachApp_TaskID, BYB_STIMULATE_PULSE_ON_EVT, 1 );
-  #ifndef ROBOROACH_V10B
-    stimulationIsLeft ? (ROBOROACH_PIO_LED_LEFT = 1) : (ROBOROACH_PIO_LED_RIGHT = 1);
-  #endif
+  if ( RoboRoachPulse_NextGain( &gain ) )
+  {
+    roboRoachApp_WriteGain( gain );
+  }
 }
 
+static void roboRoachApp_HandleFinished( void )
+{
+  stopRoboRoachStimulation();
+  updateRoboRoachBeacon();
+
+  //Queued commands start back-to-back
+  if ( stimulationQueueCount )
+  {
+    uint8 isLeft = stimulationQueue[stimulationQueueHead];
 
+    stimulationQueueHead = (stimulationQueueHead + 1) % ROBOROACH_STIM_QUEUE_LEN;
+    stimulationQueueCount--;
+    stimulationIsLeft = isLeft;
+    stimulationCurrentDuration = 0;
+    startRoboRoachStimulation();
+  }
+}
 
+#if defined ( ROBOROACH_EVENT_STATS )
 /*********************************************************************
- * @fn      roboRoachApp_ProcessOSALMsg
+ * @fn      eventStatsNow
  *
- * @brief   Process an incoming task message.
+ * @brief   Read the 24-bit sleep timer (32.768 kHz). It keeps counting in
+ *          every power mode and is not used by the pulse or LED drivers.
  *
- * @param   pMsg - message to process
+ * @param   none
+ *
+ * @return  sleep timer ticks
+ */
+static uint32 eventStatsNow( void )
+{
+  uint32 ticks;
+
+  // Reading ST0 latches ST1 and ST2
+  ticks = ST0;
+  ticks |= (uint32)ST1 << 8;
+  ticks |= (uint32)ST2 << 16;
+  return ( ticks );
+}
+
+/*********************************************************************
+ * @fn      eventStatsRecord
+ *
+ * @brief   Add one handler run to the statistics of a table entry.
+ *
+ * @param   index - entry in roboRoachEvents
+ * @param   ticks - sleep timer ticks the handler took (24-bit wrap)
  *
  * @return  none
  */
-static void roboRoachApp_ProcessOSALMsg( osal_event_hdr_t *pMsg )
+static void eventStatsRecord( uint8 index, uint32 ticks )
 {
-  switch ( pMsg->event )
+  eventStats_t *pStats = &eventStats[index];
+
+  ticks &= 0x00FFFFFFUL;
+  if ( pStats->count < 0xFFFF )
   {
-  #if defined( CC2540_MINIDK )
-  
-  case KEY_CHANGE:
-      //roboRoachApp_HandleKeys( ((keyChange_t *)pMsg)->state, ((keyChange_t *)pMsg)->keys );
-      break;
-  #endif // #if defined( CC2540_MINIDK )
-      
-  default:
-    // do nothing
-    break;
+    pStats->count++;
+    pStats->total += ticks;
+  }
+  if ( ticks > pStats->max )
+  {
+    pStats->max = ( ticks > 0xFFFF ) ? 0xFFFF : (uint16)ticks;
   }
 }
 
 /*********************************************************************
- * @fn      peripheralStateNotificationCB
+ * @fn      eventStatsReset
  *
- * @brief   Notification from the profile of a state change.
+ * @brief   Clear the statistics of every table entry.
  *
- * @param   newState - new state
+ * @param   none
  *
  * @return  none
  */
-static void peripheralStateNotificationCB( gaprole_States_t newState )
+static void eventStatsReset( void )
 {
-  switch ( newState )
-  {
-    case GAPROLE_STARTED:
-      {
-        uint8 ownAddress[B_ADDR_LEN];
-        uint8 systemId[DEVINFO_SYSTEM_ID_LEN];
+  VOID osal_memset( eventStats, 0, sizeof( eventStats ) );
+}
 
-        GAPRole_GetParameter(GAPROLE_BD_ADDR, ownAddress);
+/*********************************************************************
+ * @fn      eventStatsUs
+ *
+ * @brief   Convert sleep timer ticks to us, saturated to 16 bits (a
+ *          handler over 65 ms reads as 0xFFFF instead of wrapping).
+ *
+ * @param   ticks - sleep timer ticks
+ *
+ * @return  time in us
+ */
+static uint16 eventStatsUs( uint32 ticks )
+{
+  uint32 us;
 
-        // use 6 bytes of device address for 8 bytes of system ID value
-        systemId[0] = ownAddress[0];
-        systemId[1] = ownAddress[1];
-        systemId[2] = ownAddress[2];
+  // Far past the limit already, and keeps the product in 32 bits
+  if ( ticks > 0xFFFF )
+  {
+    return ( 0xFFFF );
+  }
+  us = ( ticks * 15625UL ) >> 9;
+  return ( ( us > 0xFFFF ) ? 0xFFFF : (uint16)us );
+}
+
+/*********************************************************************
+ * @fn      eventStatsRead
+ *
+ * @brief   Profile read callback for the Event Statistics characteristic.
+ *          One ROBOROACH_EVENT_STATS_RECORD_LEN record per table entry,
+ *          in priority order: event bit, count, max and average time in
+ *          us (all little endian). Long reads continue at offset.
+ *
+ * @param   pValue - where to copy the value
+ * @param   offset - first octet to copy
+ * @param   maxLen - room in pValue
+ *
+ * @return  number of octets copied
+ */
+static uint8 eventStatsRead( uint8 *pValue, uint16 offset, uint8 maxLen )
+{
+  uint8  record[ROBOROACH_EVENT_STATS_RECORD_LEN];
+  uint16 pos;
+  uint8  len = 0;
+
+  for ( pos = offset; ( pos < ROBOROACH_NUM_EVENTS * ROBOROACH_EVENT_STATS_RECORD_LEN ) && ( len < maxLen ); pos++ )
+  {
+    uint8 index = pos / ROBOROACH_EVENT_STATS_RECORD_LEN;
+    uint8 field = pos % ROBOROACH_EVENT_STATS_RECORD_LEN;
+
+    if ( ( field == 0 ) || ( len == 0 ) )
+    {
+      eventStats_t *pStats = &eventStats[index];
+      uint16 maxUs = eventStatsUs( pStats->max );
+      uint16 avgUs = 0;
+
+      if ( pStats->count )
+      {
+        avgUs = eventStatsUs( pStats->total / pStats->count );
+      }
+      record[0] = LO_UINT16( roboRoachEvents[index].event );
+      record[1] = HI_UINT16( roboRoachEvents[index].event );
+      record[2] = LO_UINT16( pStats->count );
+      record[3] = HI_UINT16( pStats->count );
+      record[4] = LO_UINT16( maxUs );
+      record[5] = HI_UINT16( maxUs );
+      record[6] = LO_UINT16( avgUs );
+      record[7] = HI_UINT16( avgUs );
+    }
+    pValue[len++] = record[field];
+  }
+
+  return ( len );
+}
+#endif // ROBOROACH_EVENT_STATS
+
+
+void startRoboRoachStimulation(){
+  
+  uint8  channel;
+  uint8  live;
+  uint8  gain;
+  uint32 maxPeriodUs;
+
+  RoboRoachLatency_Mark( ROBOROACH_LATENCY_START );
+
+  stimulationInProgress = 1;
+  stimulationPulseCount = 0;   
+
+  //Train boundary: writes made since the last train take effect here
+  swapRoboRoachParams();
+  
+  channel = stimulationIsLeft ? ROBOROACH_ANTENNA_LEFT_T1_CHANNEL : ROBOROACH_ANTENNA_RIGHT_T1_CHANNEL;
+
+  if ( pStimActive->randomMode )
+  {
+    uint16 periodA, periodB;
+
+    //ifZero() prevents divison by zero in the 'random mode' calculations
+    //     by setting any of the stim params that are zero to one
+    ifZero();
+
+    //The divisions are done once per train, not once per pulse. Each
+    //range starts at the smaller of its two limits, whichever was
+    //written as the minimum.
+    periodA = 1000/pStimActive->freqMin;
+    periodB = 1000/pStimActive->freqMax;
+    stimulationPeriodMin = (periodA < periodB) ? periodA : periodB;
+    stimulationPeriodSpan = (periodA > periodB) ? (periodA - periodB) : (periodB - periodA);
+    stimulationPWMin = (pStimActive->pwMin < pStimActive->pwMax) ? pStimActive->pwMin : pStimActive->pwMax;
+    stimulationPWSpan = (pStimActive->pwMax > pStimActive->pwMin) ? (pStimActive->pwMax - pStimActive->pwMin) : (pStimActive->pwMin - pStimActive->pwMax);
+    stimulationGainMin = (pStimActive->gainMin < pStimActive->gainMax) ? pStimActive->gainMin : pStimActive->gainMax;
+    stimulationGainSpan = (pStimActive->gainMax > pStimActive->gainMin) ? (pStimActive->gainMax - pStimActive->gainMin) : (pStimActive->gainMin - pStimActive->gainMax);
+    maxPeriodUs = (uint32)( stimulationPeriodMin + stimulationPeriodSpan ) * 1000;
+  }
+  else
+  {
+    if ( pStimActive->periodMs == 0 )
+    {
+      pStimActive->periodMs = 1;
+    }
+    maxPeriodUs = pStimActive->periodUs ? pStimActive->periodUs : (uint32)pStimActive->periodMs * 1000;
+
+    //With live updates the period may grow during the train; Timer 1
+    //keeps one tick size per train, so open it for the longest period
+    RoboRoachProfile_GetParameter( ROBOROACH_LIVE_UPDATE, &live );
+    if ( live && ( maxPeriodUs <= ROBOROACH_PULSE_MAX_PERIOD_US ) )
+    {
+      maxPeriodUs = ROBOROACH_PULSE_MAX_PERIOD_US;
+    }
+  }
+
+  stimulationMode = RoboRoachPulse_Open( channel, maxPeriodUs );
+  fillRoboRoachSchedule();
+  stimulationStartTime = osal_GetSystemClock();
+
+  #ifndef ROBOROACH_V10B
+    stimulationIsLeft ? (ROBOROACH_PIO_LED_LEFT = 1) : (ROBOROACH_PIO_LED_RIGHT = 1);
+  #endif
+
+  if ( stimulationMode == ROBOROACH_PULSE_ON_TIMER1 )
+  {
+    //The first pulse must not start while its wiper writes are going out
+    if ( RoboRoachPulse_NextGain( &gain ) && roboRoachApp_WriteGain( gain ) )
+    {
+      stimulationGainWait = TRUE;
+    }
+    else
+    {
+      RoboRoachPulse_Go();
+      RoboRoachLatency_Mark( ROBOROACH_LATENCY_EDGE );
+    }
+  }
+  else
+  {
+    //First pulse now; the handler arms the timers of the next ones
+    roboRoachApp_HandlePulseOn();
+  }
+
+  RoboRoachProfile_SetStatus( ROBOROACH_STATUS_STARTED, stimulationIsLeft, stimulationQueueCount );
+}
+
+/*********************************************************************
+ * @fn      roboRoachApp_HoldPower
+ *
+ * @brief   Keep the 32 MHz clock running while any driver needs a timer
+ *          that stops in PM2. The application task carries the hold for
+ *          all of them.
+ *
+ * @param   user - ROBOROACH_POWER_PULSE or ROBOROACH_POWER_POT
+ * @param   hold - TRUE to hold the clock, FALSE to release it
+ *
+ * @return  none
+ */
+void roboRoachApp_HoldPower( uint8 user, bool hold )
+{
+  if ( hold )
+  {
+    powerHolders |= user;
+  }
+  else
+  {
+    powerHolders &= ~user;
+  }
+
+  osal_pwrmgr_task_state( roboRoachApp_TaskID, powerHolders ? PWRMGR_HOLD : PWRMGR_CONSERVE );
+}
+
+/*********************************************************************
+ * @fn      takeRoboRoachCommands
+ *
+ * @brief   Take every stimulate command written since the last call, in
+ *          order. Each one starts now, or is queued/dropped by the
+ *          command policy. Runs in the profile's write callback, so the
+ *          first edge of a train follows the write without a timer hop;
+ *          BYB_STIMULATE_LEFT_EVT / _RIGHT_EVT call it again for anything
+ *          left.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void takeRoboRoachCommands( void )
+{
+  uint8 isLeft;
+
+  RoboRoachLatency_Mark( ROBOROACH_LATENCY_DISPATCH );
+  while ( RoboRoachProfile_GetCommand( &isLeft ) )
+  {
+    requestRoboRoachStimulation( isLeft );
+  }
+  //Queued or rejected: its start will not be the write's
+  RoboRoachLatency_Discard( ROBOROACH_LATENCY_DISPATCH );
+}
+
+/*********************************************************************
+ * @fn      requestRoboRoachStimulation
+ *
+ * @brief   Handle a stimulate command. It starts at once when no train is
+ *          running; otherwise the command policy characteristic decides
+ *          whether it is dropped, queued, or replaces the running train.
+ *
+ * @param   isLeft - 1 for the left antenna, 0 for the right
+ *
+ * @return  TRUE if the command was started or queued
+ */
+static uint8 requestRoboRoachStimulation( uint8 isLeft )
+{
+  uint8 policy = ROBOROACH_POLICY_DROP;
+
+  if ( !stimulationInProgress )
+  {
+    stimulationIsLeft = isLeft;
+    stimulationCurrentDuration = 0;
+    startRoboRoachStimulation();
+    return ( TRUE );
+  }
+
+  RoboRoachProfile_GetParameter( ROBOROACH_COMMAND_POLICY, &policy );
+  switch ( policy )
+  {
+    case ROBOROACH_POLICY_FIFO:
+      if ( stimulationQueueCount == ROBOROACH_STIM_QUEUE_LEN )
+      {
+        RoboRoachProfile_SetStatus( ROBOROACH_STATUS_REJECTED, isLeft, stimulationQueueCount );
+        return ( FALSE );
+      }
+      queueRoboRoachStimulation( isLeft );
+      return ( TRUE );
+
+    case ROBOROACH_POLICY_PREEMPT:
+      if ( isLeft != stimulationIsLeft )
+      {
+        //Steering the other way: drop everything and switch now
+        stimulationQueueCount = 0;
+        stopRoboRoachStimulation();
+        stimulationIsLeft = isLeft;
+        stimulationCurrentDuration = 0;
+        startRoboRoachStimulation();
+        return ( TRUE );
+      }
+      //Same side: keep only the latest, like ROBOROACH_POLICY_LATEST
+      stimulationQueueCount = 0;
+      queueRoboRoachStimulation( isLeft );
+      return ( TRUE );
+
+    case ROBOROACH_POLICY_LATEST:
+      stimulationQueueCount = 0;
+      queueRoboRoachStimulation( isLeft );
+      return ( TRUE );
+
+    default:
+      //Don't allow multiple stimulations
+      RoboRoachProfile_SetStatus( ROBOROACH_STATUS_REJECTED, isLeft, stimulationQueueCount );
+      return ( FALSE );
+  }
+}
+
+/*********************************************************************
+ * @fn      queueRoboRoachStimulation
+ *
+ * @brief   Append a command to the stimulation queue. The caller checks
+ *          that there is room.
+ *
+ * @param   isLeft - 1 for the left antenna, 0 for the right
+ *
+ * @return  none
+ */
+static void queueRoboRoachStimulation( uint8 isLeft )
+{
+  stimulationQueue[(stimulationQueueHead + stimulationQueueCount) % ROBOROACH_STIM_QUEUE_LEN] = isLeft;
+  stimulationQueueCount++;
+  RoboRoachProfile_SetStatus( ROBOROACH_STATUS_QUEUED, isLeft, stimulationQueueCount );
+}
+
+/*********************************************************************
+ * @fn      stopRoboRoachStimulation
+ *
+ * @brief   End the running train: release Timer 1, cancel the OSAL pulse
+ *          timers, turn the antenna and LED off and notify the status.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void stopRoboRoachStimulation( void )
+{
+  //Release Timer 1 (no-op when the train ran on OSAL timers)
+  RoboRoachPulse_Stop();
+
+  RoboRoachTimer_Stop( BYB_STIMULATE_PULSE_ON_EVT | BYB_STIMULATE_PULSE_OFF_EVT | BYB_STIMULATE_FINISHED_EVT );
+  osal_clear_event( roboRoachApp_TaskID, BYB_STIMULATE_PULSE_ON_EVT | BYB_STIMULATE_PULSE_OFF_EVT |
+                                         BYB_STIMULATE_FINISHED_EVT );
+  stimulationGainWait = FALSE;
+
+  if (stimulationIsLeft) {
+    ROBOROACH_PIO_ANTENNA_LEFT = 0;
+  } else {
+    ROBOROACH_PIO_ANTENNA_RIGHT = 0;
+  }
+  #ifndef ROBOROACH_V10B
+    stimulationIsLeft ? (ROBOROACH_PIO_LED_LEFT = 0) : (ROBOROACH_PIO_LED_RIGHT = 0);
+  #endif
+  if ( stimulationInProgress )
+  {
+    stimulationInProgress = 0;
+    RoboRoachProfile_SetStatus( ROBOROACH_STATUS_FINISHED, stimulationIsLeft, stimulationQueueCount );
+  }
+}
+
+/*********************************************************************
+ * @fn      requestConnectionProfile
+ *
+ * @brief   Ask the central for the steering or the idle connection
+ *          parameters. Nothing is sent when that profile was already
+ *          requested on this connection.
+ *
+ * @param   profile - CONN_PROFILE_STEERING or CONN_PROFILE_IDLE
+ *
+ * @return  none
+ */
+static void requestConnectionProfile( uint8 profile )
+{
+  uint16 minInterval, maxInterval, latency, timeout;
+  uint8  request = TRUE;
+
+  if ( !isConnected || ( connProfile == profile ) )
+  {
+    return;
+  }
+
+  if ( profile == CONN_PROFILE_STEERING )
+  {
+    minInterval = BYB_STEERING_MIN_CONN_INTERVAL;
+    maxInterval = BYB_STEERING_MAX_CONN_INTERVAL;
+    latency = BYB_STEERING_SLAVE_LATENCY;
+    timeout = BYB_STEERING_CONN_TIMEOUT;
+  }
+  else
+  {
+    minInterval = BYB_IDLE_MIN_CONN_INTERVAL;
+    maxInterval = BYB_IDLE_MAX_CONN_INTERVAL;
+    latency = BYB_IDLE_SLAVE_LATENCY;
+    timeout = BYB_IDLE_CONN_TIMEOUT;
+  }
+
+  GAPRole_SetParameter( GAPROLE_MIN_CONN_INTERVAL, sizeof( uint16 ), &minInterval );
+  GAPRole_SetParameter( GAPROLE_MAX_CONN_INTERVAL, sizeof( uint16 ), &maxInterval );
+  GAPRole_SetParameter( GAPROLE_SLAVE_LATENCY, sizeof( uint16 ), &latency );
+  GAPRole_SetParameter( GAPROLE_TIMEOUT_MULTIPLIER, sizeof( uint16 ), &timeout );
+  GAPRole_SetParameter( GAPROLE_PARAM_UPDATE_REQ, sizeof( uint8 ), &request );
+
+  connProfile = profile;
+}
+
+/*********************************************************************
+ * @fn      fillRoboRoachSchedule
+ *
+ * @brief   Top up the pulse schedule. A fixed train is one step repeated
+ *          for the whole duration; the microsecond period and width
+ *          characteristics override the frequency and ms width when set.
+ *          A random train gets one step per pulse, drawn here ahead of
+ *          time instead of at every pulse edge. As before, pulses are
+ *          added until the elapsed periods reach the duration, and there
+ *          is always at least one.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void fillRoboRoachSchedule( void )
+{
+  uint16 duration = (uint16)pStimActive->duration * 5;
+
+  if ( !pStimActive->randomMode )
+  {
+    uint32 periodUs = pStimActive->periodUs ? pStimActive->periodUs : (uint32)pStimActive->periodMs * 1000;
+    uint32 widthUs = pStimActive->pulseWidthUs ? pStimActive->pulseWidthUs : (uint32)pStimActive->pulseWidth * 1000;
+    uint16 count = (uint16)( ( (uint32)duration * 1000 + periodUs - 1 ) / periodUs );
+
+    if ( count == 0 )
+    {
+      count = 1;
+    }
+    RoboRoachPulse_Push( periodUs, widthUs, pStimActive->gain, count );
+    RoboRoachPulse_Close();
+    return;
+  }
+
+  while ( RoboRoachPulse_Space() )
+  {
+    uint16 period = stimulationPeriodMin;
+    uint8  width = stimulationPWMin;
+    uint8  gain = stimulationGainMin;
+
+    if ( stimulationPeriodSpan )
+    {
+      period += osal_rand() % stimulationPeriodSpan;
+    }
+    if ( stimulationPWSpan )
+    {
+      width += osal_rand() % stimulationPWSpan;
+    }
+    if ( stimulationGainSpan )
+    {
+      gain += osal_rand() % stimulationGainSpan;
+    }
+
+    RoboRoachPulse_Push( (uint32)period * 1000, (uint32)width * 1000, gain, 1 );
+
+    stimulationCurrentDuration += period;
+    if ( stimulationCurrentDuration >= duration )
+    {
+      RoboRoachPulse_Close();
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      roboRoachApp_ProcessOSALMsg
+ *
+ * @brief   Process an incoming task message.
+ *
+ * @param   pMsg - message to process
+ *
+ * @return  none
+ */
+static void roboRoachApp_ProcessOSALMsg( osal_event_hdr_t *pMsg )
+{
+  switch ( pMsg->event )
+  {
+  #if defined( CC2540_MINIDK )
+  
+  case KEY_CHANGE:
+      //roboRoachApp_HandleKeys( ((keyChange_t *)pMsg)->state, ((keyChange_t *)pMsg)->keys );
+      break;
+  #endif // #if defined( CC2540_MINIDK )
+      
+  default:
+    // do nothing
+    break;
+  }
+}
+
+/*********************************************************************
+ * @fn      peripheralStateNotificationCB
+ *
+ * @brief   Notification from the profile of a state change.
+ *
+ * @param   newState - new state
+ *
+ * @return  none
+ */
+static void peripheralStateNotificationCB( gaprole_States_t newState )
+{
+  switch ( newState )
+  {
+    case GAPROLE_STARTED:
+      {
+        uint8 ownAddress[B_ADDR_LEN];
+        uint8 systemId[DEVINFO_SYSTEM_ID_LEN];
+
+        GAPRole_GetParameter(GAPROLE_BD_ADDR, ownAddress);
+
+        // use 6 bytes of device address for 8 bytes of system ID value
+        systemId[0] = ownAddress[0];
+        systemId[1] = ownAddress[1];
+        systemId[2] = ownAddress[2];
 
         // set middle bytes to zero
         systemId[4] = 0x00;
@@ -773,6 +1516,11 @@ static void peripheralStateNotificationCB( gaprole_States_t newState )
 
         DevInfo_SetParameter(DEVINFO_SYSTEM_ID, DEVINFO_SYSTEM_ID_LEN, systemId);
 
+        // the status beacon tells roaches apart by the low address bytes
+        advertData[ADVERT_BEACON_OFS + ROBOROACH_BEACON_OFS_SHORT_ID] = ownAddress[0];
+        advertData[ADVERT_BEACON_OFS + ROBOROACH_BEACON_OFS_SHORT_ID + 1] = ownAddress[1];
+        GAPRole_SetParameter( GAPROLE_ADVERT_DATA, sizeof( advertData ), advertData );
+
       }
       break;
 
@@ -782,11 +1530,23 @@ static void peripheralStateNotificationCB( gaprole_States_t newState )
           HalLcdWriteString( "Advertising",  HAL_LCD_LINE_3 );
         #endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
           
+        //Same advertising at a new interval, nothing else changed
+        if ( advertRestart )
+        {
+          advertRestart = FALSE;
+          break;
+        }
+
         //Turn off everything.  
         P0 = 0; P1 = 0; P2 = 0;  
         
         //blink yellow LEDs slowly to indicate advertising
-        osal_start_timerEx( roboRoachApp_TaskID, BYB_ADV_PULSE_ON_EVT, 1 );
+        advertBlinkLit = FALSE;
+        RoboRoachTimer_Start( BYB_ADV_PULSE_EVT, 1 );
+
+        //what a scan shows until the next connection
+        Batt_MeasLevel( );
+        updateRoboRoachBeacon();
       }
       break;
 
@@ -796,30 +1556,35 @@ static void peripheralStateNotificationCB( gaprole_States_t newState )
           HalLcdWriteString( "Connected",  HAL_LCD_LINE_3 );
         #endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
         
-        connectPulseCount = 0;
         isConnected = TRUE;
+        connProfile = CONN_PROFILE_NONE;
+
+        //a central can connect before the restarted advertising is reported
+        advertRestart = FALSE;
         
-        //start connection lights
-        osal_start_timerEx( roboRoachApp_TaskID, BYB_CONNECT_PULSE_ON_EVT, 1 ); 
+        //flash connection lights until the link is lost
+        RoboRoachLed_SetConnection( ROBOROACH_LED_FLASH );
         
         //start battery check
-        osal_start_timerEx( roboRoachApp_TaskID, BYB_BATTERY_CHECK_EVT, BYB_BATTERY_CHECK_PERIOD ); 
+        RoboRoachTimer_Start( BYB_BATTERY_CHECK_EVT, BYB_BATTERY_CHECK_PERIOD ); 
       }
       break;
       
     case GAPROLE_WAITING:
       {
+        //Advertising stopped for a new interval: start it again
+        if ( advertRestart && !isConnected )
+        {
+          uint8 advertising_enable = TRUE;
+          GAPRole_SetParameter( GAPROLE_ADVERT_ENABLED, sizeof( uint8 ), &advertising_enable );
+          break;
+        }
+
         #if (defined HAL_LCD) && (HAL_LCD == TRUE)
           HalLcdWriteString( "Disconnected",  HAL_LCD_LINE_1 );
         #endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
                 
-        if( isConnected == TRUE ) //just returned from connected state, start timer for Sleep Evt
-        {
-          osal_start_timerEx( roboRoachApp_TaskID, BYB_SLEEP_EVT, BYB_DISCONNECT_PERIOD_B4_SLEEP );
-        }
-        
-        isConnected = FALSE;   
-        
+        dropRoboRoachLink();
       }
       break;
 
@@ -828,7 +1593,7 @@ static void peripheralStateNotificationCB( gaprole_States_t newState )
         #if (defined HAL_LCD) && (HAL_LCD == TRUE)
           HalLcdWriteString( "Timed Out",  HAL_LCD_LINE_1 );
         #endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
-        isConnected = FALSE;
+        dropRoboRoachLink();
       }
       break;
 
@@ -912,6 +1677,8 @@ static void roboRoachProfileChangeCB( uint8 paramID )
       break;  
       
      case  ROBOROACH_STIMULATE_LEFT: 
+      //Start from the write callback, without a trip through the scheduler
+      takeRoboRoachCommands();
       RoboRoachProfile_GetParameter(  ROBOROACH_STIMULATE_LEFT, &newValue );
 
       #if (defined HAL_LCD) && (HAL_LCD == TRUE)
@@ -921,6 +1688,7 @@ static void roboRoachProfileChangeCB( uint8 paramID )
       break;        
       
      case  ROBOROACH_STIMULATE_RIGHT: 
+      takeRoboRoachCommands();
       RoboRoachProfile_GetParameter(  ROBOROACH_STIMULATE_RIGHT, &newValue );
 
       #if (defined HAL_LCD) && (HAL_LCD == TRUE)
@@ -984,6 +1752,20 @@ static void roboRoachProfileChangeCB( uint8 paramID )
 
       break;        
 
+    case  ROBOROACH_PARAMS:
+      loadRoboRoachParams();
+      retuneRoboRoachStimulation();
+      //Save once the writes stop, not once per write
+      paramsUnsaved = TRUE;
+      RoboRoachTimer_Start( BYB_PARAMS_SAVE_EVT, BYB_PARAMS_SAVE_DELAY );
+      break;
+
+#if defined ( ROBOROACH_EVENT_STATS )
+    case  ROBOROACH_EVENT_STATS_RESET:
+      eventStatsReset();
+      break;
+#endif
+
     default:
       // should not reach here!
       break;
@@ -1002,52 +1784,303 @@ static void roboRoachProfileChangeCB( uint8 paramID )
  */
 void ifZero(void)
 {
-      if(stimulationFreqMin == 0)
+      if(pStimActive->freqMin == 0)
       {
-       stimulationFreqMin = 1;
+       pStimActive->freqMin = 1;
       }
-      if(stimulationFreqMax == 0)
+      if(pStimActive->freqMax == 0)
       {
-       stimulationFreqMax = 1;
+       pStimActive->freqMax = 1;
       }
-      if(stimulationPWmin == 0)
+      if(pStimActive->pwMin == 0)
       {
-       stimulationPWmin = 1;
+       pStimActive->pwMin = 1;
       }
-      if(stimulationPWmax == 0)
+      if(pStimActive->pwMax == 0)
       {
-       stimulationPWmax = 1;
+       pStimActive->pwMax = 1;
       }
-      if(stimulationGainMin == 0)
+      if(pStimActive->gainMin == 0)
       {
-       stimulationGainMin = 1;
+       pStimActive->gainMin = 1;
       }
-      if(stimulationGainMax == 0)
+      if(pStimActive->gainMax == 0)
       {
-       stimulationGainMax = 1;
+       pStimActive->gainMax = 1;
       }  
       return;
 }
 
+/*********************************************************************
+ * @fn      loadRoboRoachParams
+ *
+ * @brief   Refill the pending parameter set from the profile. Called
+ *          whenever a stimulation parameter is written; a running train
+ *          keeps the active set until it ends.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void loadRoboRoachParams( void )
+{
+  RoboRoachProfile_GetParams( pStimPending );
+  stimulationParamsPending = TRUE;
+}
 
 /*********************************************************************
- * @fn      areEqual()
+ * @fn      swapRoboRoachParams
  *
- * @brief   Checks if the min and the max are equal
+ * @brief   Make the pending parameter set the active one, if anything
+ *          was written since the last swap. Only called between trains,
+ *          so every pulse of a train comes from one complete set.
  *
- * @param   minVal and maxVal
+ * @param   none
  *
- * @return  true or false
+ * @return  none
  */
-bool areEqual(uint8 minVal, uint8 maxVal)
+static void swapRoboRoachParams( void )
 {
-  if(minVal == maxVal)
+  roboRoachParams_t *pNext;
+
+  if ( !stimulationParamsPending )
   {
-    return 1;
+    return;
+  }
+  pNext = pStimPending;
+  pStimPending = pStimActive;
+  pStimActive = pNext;
+  stimulationParamsPending = FALSE;
+}
+
+/*********************************************************************
+ * @fn      retuneRoboRoachStimulation
+ *
+ * @brief   With Live Update enabled, apply a parameter write to the
+ *          running train from its next pulse on: the pending set becomes
+ *          active now and the pulse engine takes the new shape at the
+ *          pulse boundary. A new period keeps the end of the train at
+ *          its duration, counted from the first pulse, to within a pulse
+ *          or two. Random trains keep their set until the next train.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void retuneRoboRoachStimulation( void )
+{
+  uint8  live;
+  uint16 repeat = 0;
+  uint32 elapsedUs;
+  uint32 remainingUs;
+  uint32 oldPeriodUs;
+  uint32 periodUs;
+  uint32 widthUs;
+
+  RoboRoachProfile_GetParameter( ROBOROACH_LIVE_UPDATE, &live );
+  if ( !live || !stimulationInProgress || pStimActive->randomMode || pStimPending->randomMode )
+  {
+    return;
+  }
+
+  oldPeriodUs = pStimActive->periodUs ? pStimActive->periodUs : (uint32)pStimActive->periodMs * 1000;
+  swapRoboRoachParams();
+
+  if ( pStimActive->periodMs == 0 )
+  {
+    pStimActive->periodMs = 1;
+  }
+  periodUs = pStimActive->periodUs ? pStimActive->periodUs : (uint32)pStimActive->periodMs * 1000;
+  widthUs = pStimActive->pulseWidthUs ? pStimActive->pulseWidthUs : (uint32)pStimActive->pulseWidth * 1000;
+
+  //Same period: the pulses left stay as they are. A new period gets the
+  //pulses that fit in what is left of the duration, counted from about
+  //one old period ahead, where the new shape starts.
+  if ( periodUs != oldPeriodUs )
+  {
+    remainingUs = (uint32)pStimActive->duration * 5000;
+    elapsedUs = ( osal_GetSystemClock() - stimulationStartTime ) * 1000 + oldPeriodUs;
+    if ( elapsedUs >= remainingUs )
+    {
+      return;
+    }
+    remainingUs -= elapsedUs;
+    repeat = (uint16)( ( remainingUs + periodUs - 1 ) / periodUs );
+    if ( repeat == 0 )
+    {
+      repeat = 1;
+    }
+  }
+
+  RoboRoachPulse_Retune( periodUs, widthUs, pStimActive->gain, repeat );
+
+  //Between OSAL pulses the new gain can go out now, unless a pulse already
+  //waits for its own
+  if ( !RoboRoachPulse_IsActive() && !( RoboRoachTimer_Active() & BYB_STIMULATE_PULSE_OFF_EVT ) &&
+       !stimulationGainWait )
+  {
+    roboRoachApp_PrepareGain();
+  }
+}
+
+/*********************************************************************
+ * @fn      updateRoboRoachBeacon
+ *
+ * @brief   Refresh the battery, state and preset fields of the status
+ *          beacon in the advertisement. The stack only gets new data
+ *          when one of them changed.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void updateRoboRoachBeacon( void )
+{
+  uint8 beacon[ROBOROACH_BEACON_LEN];
+
+  osal_memcpy( beacon, &advertData[ADVERT_BEACON_OFS], ROBOROACH_BEACON_LEN );
+  Batt_GetParameter( BATT_PARAM_LEVEL, &beacon[ROBOROACH_BEACON_OFS_BATTERY] );
+  beacon[ROBOROACH_BEACON_OFS_STATE] = stimulationInProgress ? ROBOROACH_BEACON_STATE_STIMULATING : 0;
+  RoboRoachProfile_GetParameter( ROBOROACH_ACTIVE_PRESET, &beacon[ROBOROACH_BEACON_OFS_PRESET] );
+
+  if ( !osal_memcmp( beacon, &advertData[ADVERT_BEACON_OFS], ROBOROACH_BEACON_LEN ) )
+  {
+    osal_memcpy( &advertData[ADVERT_BEACON_OFS], beacon, ROBOROACH_BEACON_LEN );
+    GAPRole_SetParameter( GAPROLE_ADVERT_DATA, sizeof( advertData ), advertData );
+  }
+}
+
+/*********************************************************************
+ * @fn      resetRoboRoachAdvertising
+ *
+ * @brief   Go back to the fast advertising interval, after a wake up or
+ *          a lost link. roboRoachApp_HandleAdvPulse backs off from
+ *          there while nobody connects.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void resetRoboRoachAdvertising( void )
+{
+  advertBlinks = 0;
+  setRoboRoachAdvertInterval( BYB_ADV_FAST_INTERVAL );
+}
+
+/*********************************************************************
+ * @fn      dropRoboRoachLink
+ *
+ * @brief   Clean up after the link is gone, closed by the central or
+ *          timed out: count down to sleep, advertise fast again, turn
+ *          the connection LEDs off and drop the commands of the link.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void dropRoboRoachLink( void )
+{
+  if ( isConnected == TRUE ) //just returned from connected state, start timer for Sleep Evt
+  {
+    RoboRoachTimer_Start( BYB_SLEEP_EVT, BYB_DISCONNECT_PERIOD_B4_SLEEP );
+
+    //the stack advertises again right away; fast, the app may retry
+    resetRoboRoachAdvertising();
+  }
+
+  isConnected = FALSE;
+  RoboRoachLed_SetConnection( ROBOROACH_LED_OFF );
+
+  //Commands from the lost link are not carried over
+  stimulationQueueCount = 0;
+  RoboRoachTimer_Stop( BYB_CONN_IDLE_EVT );
+}
+
+/*********************************************************************
+ * @fn      setRoboRoachAdvertInterval
+ *
+ * @brief   Set the advertising interval. The stack only takes it when
+ *          advertising starts, so running advertising is turned off here
+ *          and on again from the GAPROLE_WAITING notification.
+ *
+ * @param   interval - units of 625us
+ *
+ * @return  none
+ */
+static void setRoboRoachAdvertInterval( uint16 interval )
+{
+  GAP_SetParamValue( TGAP_LIM_DISC_ADV_INT_MIN, interval );
+  GAP_SetParamValue( TGAP_LIM_DISC_ADV_INT_MAX, interval );
+  GAP_SetParamValue( TGAP_GEN_DISC_ADV_INT_MIN, interval );
+  GAP_SetParamValue( TGAP_GEN_DISC_ADV_INT_MAX, interval );
+
+  if ( ( gapProfileState == GAPROLE_ADVERTISING ) && !advertRestart )
+  {
+    uint8 advertising_enable = FALSE;
+
+    advertRestart = TRUE;
+    GAPRole_SetParameter( GAPROLE_ADVERT_ENABLED, sizeof( uint8 ), &advertising_enable );
+  }
+}
+
+/*********************************************************************
+ * @fn      restoreRoboRoachParams
+ *
+ * @brief   Load the stimulation parameters saved in SNV into the
+ *          profile. Without a saved set, or with one of another layout
+ *          version, the profile keeps its defaults.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void restoreRoboRoachParams( void )
+{
+  uint8 config[ROBOROACH_CONFIG_LEN];
+
+  if ( ( osal_snv_read( ROBOROACH_NV_PARAMS, ROBOROACH_CONFIG_LEN, config ) == SUCCESS ) &&
+       ( RoboRoachProfile_SetParameter( ROBOROACH_CONFIG, ROBOROACH_CONFIG_LEN, config ) == SUCCESS ) )
+  {
+    osal_memcpy( paramsSaved, config, ROBOROACH_CONFIG_LEN );
   }
   else
   {
-    return 0;
+    //Nothing to save until a parameter is written
+    RoboRoachProfile_GetParameter( ROBOROACH_CONFIG, paramsSaved );
+  }
+  paramsUnsaved = FALSE;
+}
+
+/*********************************************************************
+ * @fn      saveRoboRoachParams
+ *
+ * @brief   Write the stimulation parameters to SNV if they were written
+ *          since the last save. A burst of writes costs one flash write,
+ *          and none when the values ended up as they were.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void saveRoboRoachParams( void )
+{
+  uint8 config[ROBOROACH_CONFIG_LEN];
+
+  RoboRoachTimer_Stop( BYB_PARAMS_SAVE_EVT );
+  if ( !paramsUnsaved )
+  {
+    return;
+  }
+  paramsUnsaved = FALSE;
+
+  RoboRoachProfile_GetParameter( ROBOROACH_CONFIG, config );
+  if ( osal_memcmp( config, paramsSaved, ROBOROACH_CONFIG_LEN ) )
+  {
+    return;
+  }
+  if ( osal_snv_write( ROBOROACH_NV_PARAMS, ROBOROACH_CONFIG_LEN, config ) == SUCCESS )
+  {
+    osal_memcpy( paramsSaved, config, ROBOROACH_CONFIG_LEN );
   }
 }
 
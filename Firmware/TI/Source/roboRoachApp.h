@@ -45,6 +45,11 @@ extern uint16 RoboRoachPeripheral_ProcessEvent( uint8 task_id, uint16 events );
 
 extern void startRoboRoachStimulation();
 
+/*
+ * Hold or release the 32 MHz clock on behalf of a driver (ROBOROACH_POWER_*)
+ */
+extern void roboRoachApp_HoldPower( uint8 user, bool hold );
+
 /*********************************************************************
 *********************************************************************/
 
@@ -0,0 +1,232 @@
+/**************************************************************************************************
+  Filename:       roboRoachLatency.c
+
+  Description:    Stimulate command latency statistics.
+
+                  A command is timestamped when the profile receives the
+                  write, when the application task takes it from the inbox,
+                  when the train is set up and when the antenna goes high.
+                  The sleep timer (32.768 kHz, about 30 us) keeps counting in
+                  every power mode and is not used by the pulse or LED
+                  drivers. Only one command is followed at a time: a new
+                  write restarts the measurement, so with several commands
+                  in one connection event the last one is timed.
+
+                  For each stage, and for the whole path, the statistics
+                  keep the count, minimum, maximum, mean and a histogram of
+                  ROBOROACH_LATENCY_BINS bins of ROBOROACH_LATENCY_BIN_US;
+                  the last bin also takes everything longer.
+
+  Copyright 2014 Backyard Brains Incorporated. All rights reserved.
+
+**************************************************************************************************/
+
+#if defined ( ROBOROACH_LATENCY_STATS )
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <ioCC2540.h>
+#include "OSAL.h"
+
+#include "roboRoach.h"
+#include "roboRoachLatency.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define LATENCY_IDLE                0xFF
+
+// Statistics records: the three stage intervals, then the whole path
+#define LATENCY_NUM_RECORDS         4
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint16 count;
+  uint16 minUs;
+  uint16 maxUs;
+  uint32 totalUs;
+  uint16 bins[ROBOROACH_LATENCY_BINS];
+} latencyStats_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint8  latencyStage = LATENCY_IDLE;       // last stage reached
+static uint32 latencyStamp[ROBOROACH_LATENCY_EDGE + 1];
+static latencyStats_t latencyStats[LATENCY_NUM_RECORDS];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+// 24-bit sleep timer; reading ST0 latches ST1 and ST2
+static uint32 latencyNow( void )
+{
+  uint32 ticks;
+
+  ticks = ST0;
+  ticks |= (uint32)ST1 << 8;
+  ticks |= (uint32)ST2 << 16;
+  return ( ticks );
+}
+
+// Sleep timer ticks between two stamps in us, saturated to 16 bits
+static uint16 latencyUs( uint32 from, uint32 to )
+{
+  uint32 us = ( ( ( to - from ) & 0x00FFFFFFUL ) * 15625UL ) >> 9;
+
+  return ( ( us > 0xFFFF ) ? 0xFFFF : (uint16)us );
+}
+
+static void latencyRecord( latencyStats_t *pStats, uint16 us )
+{
+  uint8 bin = (uint8)( us / ROBOROACH_LATENCY_BIN_US );
+
+  if ( pStats->count == 0xFFFF )
+  {
+    return;
+  }
+  if ( ( pStats->count == 0 ) || ( us < pStats->minUs ) )
+  {
+    pStats->minUs = us;
+  }
+  if ( us > pStats->maxUs )
+  {
+    pStats->maxUs = us;
+  }
+  pStats->count++;
+  pStats->totalUs += us;
+  pStats->bins[( bin < ROBOROACH_LATENCY_BINS ) ? bin : ( ROBOROACH_LATENCY_BINS - 1 )]++;
+}
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      RoboRoachLatency_Mark
+ *
+ * @brief   Timestamp a stage of the command being followed. On the first
+ *          edge the intervals are added to the statistics.
+ *
+ * @param   stage - ROBOROACH_LATENCY_WRITE .. ROBOROACH_LATENCY_EDGE
+ *
+ * @return  none
+ */
+void RoboRoachLatency_Mark( uint8 stage )
+{
+  uint8 i;
+
+  if ( ( stage != ROBOROACH_LATENCY_WRITE ) && ( stage != (uint8)( latencyStage + 1 ) ) )
+  {
+    return;
+  }
+  latencyStamp[stage] = latencyNow();
+  latencyStage = stage;
+
+  if ( stage == ROBOROACH_LATENCY_EDGE )
+  {
+    for ( i = 0; i < ROBOROACH_LATENCY_EDGE; i++ )
+    {
+      latencyRecord( &latencyStats[i], latencyUs( latencyStamp[i], latencyStamp[i + 1] ) );
+    }
+    latencyRecord( &latencyStats[ROBOROACH_LATENCY_EDGE],
+                   latencyUs( latencyStamp[ROBOROACH_LATENCY_WRITE], latencyStamp[ROBOROACH_LATENCY_EDGE] ) );
+    latencyStage = LATENCY_IDLE;
+  }
+}
+
+/*********************************************************************
+ * @fn      RoboRoachLatency_Discard
+ *
+ * @brief   Stop following the command if it got no further than a stage,
+ *          e.g. because it was queued behind a running train.
+ *
+ * @param   stage - last stage the command may have reached
+ *
+ * @return  none
+ */
+void RoboRoachLatency_Discard( uint8 stage )
+{
+  if ( latencyStage <= stage )
+  {
+    latencyStage = LATENCY_IDLE;
+  }
+}
+
+/*********************************************************************
+ * @fn      RoboRoachLatency_Reset
+ *
+ * @brief   Clear the statistics. A command being followed still counts.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void RoboRoachLatency_Reset( void )
+{
+  VOID osal_memset( latencyStats, 0, sizeof( latencyStats ) );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachLatency_Read
+ *
+ * @brief   Profile read of the Latency Statistics characteristic. One
+ *          ROBOROACH_LATENCY_RECORD_LEN record each for write to dispatch,
+ *          dispatch to start, start to first edge and write to first
+ *          edge: record number, count, min, max and mean in us, then the
+ *          histogram bins (all little endian). Long reads continue at
+ *          offset.
+ *
+ * @param   pValue - where to copy the value
+ * @param   offset - first octet to copy
+ * @param   maxLen - room in pValue
+ *
+ * @return  number of octets copied
+ */
+uint8 RoboRoachLatency_Read( uint8 *pValue, uint16 offset, uint8 maxLen )
+{
+  uint8  record[ROBOROACH_LATENCY_RECORD_LEN];
+  uint16 pos;
+  uint8  len = 0;
+
+  for ( pos = offset; ( pos < LATENCY_NUM_RECORDS * ROBOROACH_LATENCY_RECORD_LEN ) && ( len < maxLen ); pos++ )
+  {
+    uint8 index = pos / ROBOROACH_LATENCY_RECORD_LEN;
+    uint8 field = pos % ROBOROACH_LATENCY_RECORD_LEN;
+
+    if ( ( field == 0 ) || ( len == 0 ) )
+    {
+      latencyStats_t *pStats = &latencyStats[index];
+      uint16 meanUs = pStats->count ? (uint16)( pStats->totalUs / pStats->count ) : 0;
+      uint8  bin;
+
+      record[0] = index + 1;
+      record[1] = LO_UINT16( pStats->count );
+      record[2] = HI_UINT16( pStats->count );
+      record[3] = LO_UINT16( pStats->minUs );
+      record[4] = HI_UINT16( pStats->minUs );
+      record[5] = LO_UINT16( pStats->maxUs );
+      record[6] = HI_UINT16( pStats->maxUs );
+      record[7] = LO_UINT16( meanUs );
+      record[8] = HI_UINT16( meanUs );
+      for ( bin = 0; bin < ROBOROACH_LATENCY_BINS; bin++ )
+      {
+        record[9 + 2 * bin] = LO_UINT16( pStats->bins[bin] );
+        record[10 + 2 * bin] = HI_UINT16( pStats->bins[bin] );
+      }
+    }
+    pValue[len++] = record[field];
+  }
+
+  return ( len );
+}
+
+#endif // ROBOROACH_LATENCY_STATS
@@ -0,0 +1,79 @@
+/**************************************************************************************************
+  Filename:       roboRoachLatency.h
+
+  Description:    Stimulate command latency, from the GATT write to the first
+                  antenna edge, timed per stage with the sleep timer. Built
+                  with ROBOROACH_LATENCY_STATS only; otherwise the calls
+                  compile to nothing.
+
+  Copyright 2014 Backyard Brains Incorporated. All rights reserved.
+
+**************************************************************************************************/
+
+#ifndef ROBOROACHLATENCY_H
+#define ROBOROACHLATENCY_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Stages of a command, in order
+#define ROBOROACH_LATENCY_WRITE             0   // stimulate write received
+#define ROBOROACH_LATENCY_DISPATCH          1   // command taken by the application task
+#define ROBOROACH_LATENCY_START             2   // train being set up
+#define ROBOROACH_LATENCY_EDGE              3   // first antenna edge
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+#if defined ( ROBOROACH_LATENCY_STATS )
+
+/*
+ * A command reached a stage. WRITE starts a new measurement; a later stage
+ * counts only when it follows the previous one, and EDGE completes it.
+ */
+extern void RoboRoachLatency_Mark( uint8 stage );
+
+/*
+ * Forget the measurement if it got no further than the given stage
+ * (the command was queued or rejected instead of started)
+ */
+extern void RoboRoachLatency_Discard( uint8 stage );
+
+/*
+ * Clear the statistics
+ */
+extern void RoboRoachLatency_Reset( void );
+
+/*
+ * Copy the Latency Statistics characteristic value from an offset
+ */
+extern uint8 RoboRoachLatency_Read( uint8 *pValue, uint16 offset, uint8 maxLen );
+
+#else
+
+#define RoboRoachLatency_Mark( stage )
+#define RoboRoachLatency_Discard( stage )
+#define RoboRoachLatency_Reset()
+
+#endif
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROBOROACHLATENCY_H */
@@ -0,0 +1,134 @@
+/**************************************************************************************************
+  Filename:       roboRoachLed.c
+
+  Description:    Connection indicator driver.
+
+                  The connected indicator used to be dimmed by the application
+                  task, lighting the LEDs for 1ms every 5ms. A timer output
+                  can not take over: the CC254x timers stop in PM2. Instead
+                  both connection LEDs flash for BYB_CONNECT_LED_WIDTH every
+                  BYB_CONNECT_LED_PERIOD, timed by an OSAL timer of the
+                  application task. OSAL timers run on the sleep timer, so
+                  the MCU stays in PM2 between flashes.
+
+  Copyright 2014 Backyard Brains Incorporated. All rights reserved.
+
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <ioCC2540.h>
+#include "hal_mcu.h"
+
+#include "roboRoach.h"
+#include "roboRoachLed.h"
+#include "roboRoachTimer.h"
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint8  ledMode = ROBOROACH_LED_OFF;
+static uint16 ledFlashEvent = 0;
+static bool   ledLit = FALSE;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void ledWrite( bool on );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      RoboRoachLed_Init
+ *
+ * @brief   Register the flash event and leave the indicator off.
+ *
+ * @param   flashEvent - application task event that times the flashes
+ *
+ * @return  none
+ */
+void RoboRoachLed_Init( uint16 flashEvent )
+{
+  ledFlashEvent = flashEvent;
+  ledMode = ROBOROACH_LED_OFF;
+  ledWrite( FALSE );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachLed_SetConnection
+ *
+ * @brief   Change the connection indicator. A flashing indicator starts
+ *          with a flash.
+ *
+ * @param   mode - ROBOROACH_LED_OFF, ROBOROACH_LED_ON or ROBOROACH_LED_FLASH
+ *
+ * @return  none
+ */
+void RoboRoachLed_SetConnection( uint8 mode )
+{
+  if ( mode == ledMode )
+  {
+    return;
+  }
+
+  ledMode = mode;
+  RoboRoachTimer_Stop( ledFlashEvent );
+  ledWrite( mode != ROBOROACH_LED_OFF );
+
+  // Without LEDs there is nothing to wake up for
+  if ( ( mode == ROBOROACH_LED_FLASH ) && ROBOROACH_HAS_CONNECTION_LEDS )
+  {
+    RoboRoachTimer_Start( ledFlashEvent, BYB_CONNECT_LED_WIDTH );
+  }
+}
+
+/*********************************************************************
+ * @fn      RoboRoachLed_ProcessFlash
+ *
+ * @brief   End the running flash or start the next one.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void RoboRoachLed_ProcessFlash( void )
+{
+  if ( ledMode != ROBOROACH_LED_FLASH )
+  {
+    return;
+  }
+
+  ledWrite( !ledLit );
+  RoboRoachTimer_Start( ledFlashEvent, ledLit ? BYB_CONNECT_LED_WIDTH
+                                              : BYB_CONNECT_LED_PERIOD - BYB_CONNECT_LED_WIDTH );
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      ledWrite
+ *
+ * @brief   Light or clear both connection LEDs.
+ *
+ * @param   on - TRUE to light them
+ *
+ * @return  none
+ */
+static void ledWrite( bool on )
+{
+  ledLit = on;
+
+#if ( ROBOROACH_HAS_CONNECTION_LEDS )
+  ROBOROACH_PIO_LED_CONNECTION_1 = on ? 1 : 0;
+  ROBOROACH_PIO_LED_CONNECTION_2 = on ? 1 : 0;
+#endif // ROBOROACH_HAS_CONNECTION_LEDS
+}
+
+/*********************************************************************
+*********************************************************************/
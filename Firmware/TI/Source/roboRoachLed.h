@@ -0,0 +1,61 @@
+/**************************************************************************************************
+  Filename:       roboRoachLed.h
+
+  Description:    Connection indicator driver. While connected the LEDs
+                  flash briefly every few seconds from an OSAL timer, so
+                  the MCU can stay in PM2 between flashes.
+
+  Copyright 2014 Backyard Brains Incorporated. All rights reserved.
+
+**************************************************************************************************/
+
+#ifndef ROBOROACHLED_H
+#define ROBOROACHLED_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Indicator modes, RoboRoachLed_SetConnection()
+#define ROBOROACH_LED_OFF                   0
+#define ROBOROACH_LED_ON                    1
+#define ROBOROACH_LED_FLASH                 2
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Leave the indicator off and register the application task event that
+ * times the flashes (started with RoboRoachTimer_Start)
+ */
+extern void RoboRoachLed_Init( uint16 flashEvent );
+
+/*
+ * Change the connection indicator; does nothing if the mode is unchanged
+ */
+extern void RoboRoachLed_SetConnection( uint8 mode );
+
+/*
+ * Handle the flash event: turn the LEDs on or off and time the next change
+ */
+extern void RoboRoachLed_ProcessFlash( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROBOROACHLED_H */
@@ -0,0 +1,782 @@
+/**************************************************************************************************
+  Filename:       roboRoachPulse.c
+
+  Description:    Hardware pulse engine for the RoboRoach stimulation trains.
+
+                  Timer 1 runs in modulo mode: channel 0 holds the period and the
+                  antenna channel is set to "clear output on compare-up, set on 0",
+                  so the rising edge is the counter wrap and the falling edge is
+                  the compare. The channel interrupt fires on every falling edge
+                  and loads the shape of the next pulse from a ring of schedule
+                  steps, which the timer latches at the next wrap. After the last
+                  step it stops the timer and posts the finished event.
+
+                  The application fills the ring ahead of the running pulse and
+                  tops it up on the refill event. Trains that Timer 1 can not
+                  generate use the same ring in ms, consumed by the application
+                  task with RoboRoachPulse_Fetch().
+
+                  RoboRoachPulse_Retune() hands a new shape for the rest of the
+                  running step to whichever consumer takes the next pulse,
+                  through a single-slot mailbox instead of a lock.
+
+                  The digipot gain is changed between pulses only. When a
+                  pulse is loaded, the gain of the one after it is looked up
+                  and set pending, and the gap after the loaded pulse is
+                  stretched to ROBOROACH_PULSE_GAIN_GAP_US if needed; the
+                  interrupt commits it at that pulse's falling edge. A gain
+                  that shows up later (a retune, a late refill) is committed
+                  at the next falling edge too if that gap is long enough,
+                  else it is one pulse late.
+
+  Copyright 2014 Backyard Brains Incorporated. All rights reserved.
+
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <ioCC2540.h>
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "hci.h"
+
+#include "roboRoach.h"
+#include "roboRoachApp.h"
+#include "roboRoachPulse.h"
+#include "MCP4000.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// T1CTL: prescaler and operating mode
+#define T1CTL_DIV_32                0x08  // 1us ticks
+#define T1CTL_DIV_128               0x0C  // 4us ticks
+#define T1CTL_MODE_MODULO           0x02
+
+// T1CCTLn: interrupt enabled, clear output on compare-up / set on 0, compare mode
+#define T1CCTL_PULSE                0x64
+
+// PERCFG.T1CFG: Timer 1 at alternative location 2
+#define PERCFG_T1CFG                0x40
+
+// TIMIF.T1OVFIM: Timer 1 overflow interrupt mask
+#define TIMIF_T1OVFIM               0x40
+
+#define PULSE_RING_MASK             ( ROBOROACH_PULSE_RING_LEN - 1 )
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Steps between consumer and producer; indices run freely and wrap at 256
+#define PULSE_RING_COUNT()          ( (uint8)( pulseHead - pulseTail ) )
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint8  pulseTaskId;
+static uint16 pulseFinishedEvent;
+static uint16 pulseRefillEvent;
+
+// Schedule ring: pulseHead is only written by RoboRoachPulse_Push() and
+// pulseTail only by the consumer (Timer 1 interrupt or RoboRoachPulse_Fetch())
+static pulseStep_t    pulseRing[ROBOROACH_PULSE_RING_LEN];
+static volatile uint8 pulseHead = 0;
+static volatile uint8 pulseTail = 0;
+static volatile bool  pulseClosed = TRUE;
+
+static uint8  pulseMode = ROBOROACH_PULSE_ON_OSAL;
+static uint8  pulseCtl;            // T1CTL of the open Timer 1 schedule
+static uint8  pulseShift;          // us to ticks
+static uint32 pulseMaxUs;          // longest period of the open schedule
+static uint16 pulseGainGap;        // ROBOROACH_PULSE_GAIN_GAP_US in ticks
+static uint8  pulseGain;           // gain on the wipers by the next pulse
+static uint16 pulseGap;            // low time after the loaded pulse, ticks
+static bool   pulseStretched;      // that gap was stretched for the SPI
+
+// Retune mailbox: the application fills pulseRetuneStep and then sets
+// pulseRetunePosted; the consumer takes it at the next pulse boundary.
+// The flag is cleared before the step is rewritten, so the Timer 1
+// interrupt never sees a half-written shape.
+static pulseStep_t    pulseRetuneStep;
+static volatile bool  pulseRetunePosted = FALSE;
+
+static uint8  pulseOpenChannel = ROBOROACH_T1_CHANNEL_NONE;
+static uint8  pulseChannel = ROBOROACH_T1_CHANNEL_NONE;   // running channel
+static bool   pulseHeld = FALSE;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void pulseConvert( pulseStep_t *pStep, uint32 periodUs, uint32 widthUs );
+static void pulseTakeRetune( pulseStep_t *pStep );
+static uint8 pulseNextGain( pulseStep_t *pStep );
+static void pulseLoad( pulseStep_t *pStep );
+static void pulseSetCompare( uint8 channel, uint16 ticks, uint8 ctl );
+static void pulseSelectPin( uint8 channel, bool peripheral );
+static void pulseHalt( void );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      RoboRoachPulse_Init
+ *
+ * @brief   Put Timer 1 on the antenna pins and leave it halted.
+ *
+ * @param   taskId - task to notify about the schedule
+ * @param   finishedEvent - event posted to taskId when a train ends
+ * @param   refillEvent - event posted to taskId when the ring runs low
+ *
+ * @return  none
+ */
+void RoboRoachPulse_Init( uint8 taskId, uint16 finishedEvent, uint16 refillEvent )
+{
+  pulseTaskId = taskId;
+  pulseFinishedEvent = finishedEvent;
+  pulseRefillEvent = refillEvent;
+
+  T1CTL = 0x00;
+
+  // Alternative location 2 puts channels 1-4 on P1_1, P1_0, P0_7 and P0_6,
+  // clear of the digipot SPI on P0_2 - P0_5
+  PERCFG |= PERCFG_T1CFG;
+
+  // Only the antenna channel compare interrupts; no overflow interrupt
+  TIMIF &= ~TIMIF_T1OVFIM;
+  T1CCTL0 = 0x00;
+  T1CCTL1 = 0x00;
+  T1CCTL2 = 0x00;
+  T1CCTL3 = 0x00;
+  T1CCTL4 = 0x00;
+
+  T1STAT = 0x00;
+  T1IF = 0;
+  T1IE = 1;
+}
+
+/*********************************************************************
+ * @fn      RoboRoachPulse_Open
+ *
+ * @brief   Stop any running train and start an empty schedule. The tick
+ *          size is fixed for the whole train by its longest period.
+ *
+ * @param   channel - Timer 1 channel of the antenna pin (1-4)
+ * @param   maxPeriodUs - longest period that will be pushed
+ *
+ * @return  ROBOROACH_PULSE_ON_TIMER1 or ROBOROACH_PULSE_ON_OSAL
+ */
+uint8 RoboRoachPulse_Open( uint8 channel, uint32 maxPeriodUs )
+{
+  RoboRoachPulse_Stop();
+
+  pulseHead = 0;
+  pulseTail = 0;
+  pulseClosed = FALSE;
+  pulseRetunePosted = FALSE;
+  pulseMaxUs = maxPeriodUs;
+
+  if ( ( channel == ROBOROACH_T1_CHANNEL_NONE ) || ( channel > 4 ) ||
+       ( maxPeriodUs <= ROBOROACH_PULSE_MIN_GAP_US ) || ( maxPeriodUs > ROBOROACH_PULSE_MAX_PERIOD_US ) )
+  {
+    pulseMode = ROBOROACH_PULSE_ON_OSAL;
+    pulseOpenChannel = ROBOROACH_T1_CHANNEL_NONE;
+    return ( pulseMode );
+  }
+
+  // 1us ticks while the period fits in 16 bits, 4us ticks above that
+  if ( maxPeriodUs < 0x10000UL )
+  {
+    pulseCtl = T1CTL_DIV_32 | T1CTL_MODE_MODULO;
+    pulseShift = 0;
+  }
+  else
+  {
+    pulseCtl = T1CTL_DIV_128 | T1CTL_MODE_MODULO;
+    pulseShift = 2;
+  }
+
+  pulseGainGap = ROBOROACH_PULSE_GAIN_GAP_US >> pulseShift;
+  pulseMode = ROBOROACH_PULSE_ON_TIMER1;
+  pulseOpenChannel = channel;
+  return ( pulseMode );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachPulse_Push
+ *
+ * @brief   Convert a step to the units of the open schedule and append
+ *          it to the ring.
+ *
+ * @param   periodUs - pulse period in microseconds
+ * @param   widthUs - pulse width in microseconds
+ * @param   gain - stimulation gain (0-100%)
+ * @param   repeat - number of pulses of this shape
+ *
+ * @return  TRUE if the step was added
+ */
+bool RoboRoachPulse_Push( uint32 periodUs, uint32 widthUs, uint8 gain, uint16 repeat )
+{
+  pulseStep_t *pStep;
+
+  if ( ( repeat == 0 ) || ( RoboRoachPulse_Space() == 0 ) )
+  {
+    return ( FALSE );
+  }
+
+  pStep = &pulseRing[pulseHead & PULSE_RING_MASK];
+  pulseConvert( pStep, periodUs, widthUs );
+  pStep->gain = gain;
+  pStep->repeat = repeat;
+
+  // Publish the step only once it is complete
+  pulseHead++;
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachPulse_Close
+ *
+ * @brief   No more steps follow; the train ends after the last one.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void RoboRoachPulse_Close( void )
+{
+  pulseClosed = TRUE;
+}
+
+/*********************************************************************
+ * @fn      RoboRoachPulse_Retune
+ *
+ * @brief   Give the rest of the running step a new shape from the next
+ *          pulse on. A retune that was not taken yet is replaced. Call
+ *          from the application task only.
+ *
+ * @param   periodUs - pulse period in microseconds
+ * @param   widthUs - pulse width in microseconds
+ * @param   gain - stimulation gain (0-100%)
+ * @param   repeat - pulses left in the step from the next one on, 0 to
+ *          keep the number the step has left
+ *
+ * @return  TRUE if posted, FALSE when no train is running
+ */
+bool RoboRoachPulse_Retune( uint32 periodUs, uint32 widthUs, uint8 gain, uint16 repeat )
+{
+  if ( !RoboRoachPulse_Pending() )
+  {
+    return ( FALSE );
+  }
+
+  // Withdraw the previous post before touching the step
+  pulseRetunePosted = FALSE;
+
+  pulseConvert( &pulseRetuneStep, periodUs, widthUs );
+  pulseRetuneStep.gain = gain;
+  pulseRetuneStep.repeat = repeat;
+
+  pulseRetunePosted = TRUE;
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachPulse_Space
+ *
+ * @brief   Number of steps that can still be pushed.
+ *
+ * @param   none
+ *
+ * @return  free steps, 0 once the schedule is closed
+ */
+uint8 RoboRoachPulse_Space( void )
+{
+  if ( pulseClosed )
+  {
+    return ( 0 );
+  }
+  return ( ROBOROACH_PULSE_RING_LEN - PULSE_RING_COUNT() );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachPulse_Go
+ *
+ * @brief   Start the open Timer 1 schedule. The first rising edge comes
+ *          as the timer starts, so the caller writes the gain of the first
+ *          step (RoboRoachPulse_NextGain) and waits for the digipot first.
+ *
+ * @param   none
+ *
+ * @return  SUCCESS, or FAILURE if there is nothing to run on Timer 1
+ */
+uint8 RoboRoachPulse_Go( void )
+{
+  pulseStep_t *pStep;
+
+  if ( ( pulseMode != ROBOROACH_PULSE_ON_TIMER1 ) || ( PULSE_RING_COUNT() == 0 ) )
+  {
+    return ( FAILURE );
+  }
+
+  pStep = &pulseRing[pulseTail & PULSE_RING_MASK];
+  pulseGain = pStep->gain;
+
+  // PM2 stops Timer 1 and dividing the clock on halt stretches its ticks,
+  // so keep the 32 MHz clock running until the train is over
+  roboRoachApp_HoldPower( ROBOROACH_POWER_PULSE, TRUE );
+  HCI_EXT_ClkDivOnHaltCmd( HCI_EXT_DISABLE_CLK_DIVIDE_ON_HALT );
+  pulseHeld = TRUE;
+
+  pulseChannel = pulseOpenChannel;
+  pulseLoad( pStep );
+  pulseSelectPin( pulseChannel, TRUE );
+
+  T1STAT = 0x00;
+  T1IF = 0;
+
+  // Any write to T1CNTL clears the counter; the output is set at 0
+  T1CNTL = 0x00;
+  T1CTL = pulseCtl;
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachPulse_Fetch
+ *
+ * @brief   Take one pulse of an OSAL schedule and ask for a refill when
+ *          the ring runs low.
+ *
+ * @param   pStep - filled with the shape of the pulse (repeat is unused)
+ *
+ * @return  TRUE if a pulse was taken
+ */
+bool RoboRoachPulse_Fetch( pulseStep_t *pStep )
+{
+  pulseStep_t *pHead;
+
+  if ( PULSE_RING_COUNT() == 0 )
+  {
+    return ( FALSE );
+  }
+
+  pHead = &pulseRing[pulseTail & PULSE_RING_MASK];
+  if ( pulseRetunePosted )
+  {
+    pulseTakeRetune( pHead );
+  }
+  *pStep = *pHead;
+
+  if ( --pHead->repeat == 0 )
+  {
+    pulseTail++;
+    if ( !pulseClosed && ( PULSE_RING_COUNT() <= ROBOROACH_PULSE_RING_LEN / 2 ) )
+    {
+      osal_set_event( pulseTaskId, pulseRefillEvent );
+    }
+  }
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachPulse_NextGain
+ *
+ * @brief   Look up the gain of the pulse RoboRoachPulse_Fetch() takes
+ *          next, a posted retune first, without taking it. Before
+ *          RoboRoachPulse_Go() this is the first pulse of a Timer 1 train.
+ *
+ * @param   pGain - filled with the gain (0-100%)
+ *
+ * @return  TRUE if a pulse is queued
+ */
+bool RoboRoachPulse_NextGain( uint8 *pGain )
+{
+  if ( PULSE_RING_COUNT() == 0 )
+  {
+    return ( FALSE );
+  }
+
+  *pGain = pulseRetunePosted ? pulseRetuneStep.gain : pulseRing[pulseTail & PULSE_RING_MASK].gain;
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachPulse_Pending
+ *
+ * @brief   Check whether the open schedule has pulses left to deliver.
+ *
+ * @param   none
+ *
+ * @return  TRUE if more pulses follow
+ */
+bool RoboRoachPulse_Pending( void )
+{
+  return ( ( PULSE_RING_COUNT() != 0 ) || !pulseClosed );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachPulse_Stop
+ *
+ * @brief   Halt the timer, drop the schedule, drive the antenna pin low
+ *          and let the device sleep again. Safe to call when no train is
+ *          running.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void RoboRoachPulse_Stop( void )
+{
+  halIntState_t intState;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );
+  if ( pulseChannel != ROBOROACH_T1_CHANNEL_NONE )
+  {
+    pulseHalt();
+  }
+  pulseTail = pulseHead;
+  pulseClosed = TRUE;
+  HAL_EXIT_CRITICAL_SECTION( intState );
+
+  if ( pulseHeld )
+  {
+    pulseHeld = FALSE;
+    HCI_EXT_ClkDivOnHaltCmd( HCI_EXT_ENABLE_CLK_DIVIDE_ON_HALT );
+    roboRoachApp_HoldPower( ROBOROACH_POWER_PULSE, FALSE );
+  }
+}
+
+/*********************************************************************
+ * @fn      RoboRoachPulse_IsActive
+ *
+ * @brief   Check whether a hardware train is running.
+ *
+ * @param   none
+ *
+ * @return  TRUE while Timer 1 is generating pulses
+ */
+bool RoboRoachPulse_IsActive( void )
+{
+  return ( pulseChannel != ROBOROACH_T1_CHANNEL_NONE );
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      pulseConvert
+ *
+ * @brief   Fill the period and width of a step in the units of the open
+ *          schedule. Timer 1 widths are kept clear of the next rising
+ *          edge so the compare always fires.
+ *
+ * @param   pStep - step to fill
+ * @param   periodUs - pulse period in microseconds
+ * @param   widthUs - pulse width in microseconds
+ *
+ * @return  none
+ */
+static void pulseConvert( pulseStep_t *pStep, uint32 periodUs, uint32 widthUs )
+{
+  if ( pulseMode == ROBOROACH_PULSE_ON_TIMER1 )
+  {
+    if ( periodUs > pulseMaxUs )
+    {
+      periodUs = pulseMaxUs;
+    }
+    if ( periodUs <= ROBOROACH_PULSE_MIN_GAP_US )
+    {
+      periodUs = ROBOROACH_PULSE_MIN_GAP_US + 1;
+    }
+    if ( widthUs > periodUs - ROBOROACH_PULSE_MIN_GAP_US )
+    {
+      widthUs = periodUs - ROBOROACH_PULSE_MIN_GAP_US;
+    }
+
+    pStep->period = (uint16)( periodUs >> pulseShift );
+    pStep->width = (uint16)( widthUs >> pulseShift );
+    if ( pStep->width == 0 )
+    {
+      pStep->width = 1;
+    }
+  }
+  else
+  {
+    // Nearest ms for the period; a sub-ms pulse still lasts one tick
+    pStep->period = (uint16)( ( periodUs + 500 ) / 1000 );
+    pStep->width = (uint16)( ( widthUs + 999 ) / 1000 );
+    if ( pStep->period == 0 )
+    {
+      pStep->period = 1;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      pulseTakeRetune
+ *
+ * @brief   Replace the running step with the posted retune. Called by
+ *          the consumer of the ring at a pulse boundary.
+ *
+ * @param   pStep - running step at the tail of the ring
+ *
+ * @return  none
+ */
+static void pulseTakeRetune( pulseStep_t *pStep )
+{
+  pulseRetunePosted = FALSE;
+  pStep->period = pulseRetuneStep.period;
+  pStep->width = pulseRetuneStep.width;
+  pStep->gain = pulseRetuneStep.gain;
+  if ( pulseRetuneStep.repeat != 0 )
+  {
+    pStep->repeat = pulseRetuneStep.repeat;
+  }
+}
+
+/*********************************************************************
+ * @fn      pulseNextGain
+ *
+ * @brief   Gain of the pulse after the one of the given step that is
+ *          about to start: a posted retune, the same step, or the next
+ *          step in the ring. Without any of them the gain stays.
+ *
+ * @param   pStep - step at the tail of the ring
+ *
+ * @return  gain (0-100%)
+ */
+static uint8 pulseNextGain( pulseStep_t *pStep )
+{
+  if ( pulseRetunePosted )
+  {
+    return ( pulseRetuneStep.gain );
+  }
+  if ( ( pStep->repeat > 1 ) || ( PULSE_RING_COUNT() < 2 ) )
+  {
+    return ( pStep->gain );
+  }
+  return ( pulseRing[( pulseTail + 1 ) & PULSE_RING_MASK].gain );
+}
+
+/*********************************************************************
+ * @fn      pulseLoad
+ *
+ * @brief   Load the period and width of the next pulse and set the gain
+ *          of the one after it pending. While the timer runs the new
+ *          values are latched when the counter next reaches 0.
+ *
+ * @param   pStep - step in timer ticks
+ *
+ * @return  none
+ */
+static void pulseLoad( pulseStep_t *pStep )
+{
+  uint16 top = pStep->period - 1;
+  uint8 nextGain = pulseNextGain( pStep );
+
+  // The wiper writes go out after this pulse; keep the gap long enough
+  pulseGap = pStep->period - pStep->width;
+  pulseStretched = FALSE;
+  if ( nextGain != pulseGain )
+  {
+    pulseGain = nextGain;
+    Gain_SetPending( nextGain );
+    if ( pulseGap < pulseGainGap )
+    {
+      top = ( pStep->width < 0xFFFF - pulseGainGap ) ? ( pStep->width + pulseGainGap - 1 ) : 0xFFFF;
+      pulseGap = pulseGainGap;
+      pulseStretched = TRUE;
+    }
+  }
+
+  // T1CC0 is taken when the high byte is written
+  T1CC0L = LO_UINT16( top );
+  T1CC0H = HI_UINT16( top );
+  pulseSetCompare( pulseChannel, pStep->width, T1CCTL_PULSE );
+}
+
+/*********************************************************************
+ * @fn      pulseSetCompare
+ *
+ * @brief   Load the compare value and control register of a channel.
+ *
+ * @param   channel - Timer 1 channel (1-4)
+ * @param   ticks - compare value
+ * @param   ctl - T1CCTLn value
+ *
+ * @return  none
+ */
+static void pulseSetCompare( uint8 channel, uint16 ticks, uint8 ctl )
+{
+  switch ( channel )
+  {
+    case 1:
+      T1CC1L = LO_UINT16( ticks );
+      T1CC1H = HI_UINT16( ticks );
+      T1CCTL1 = ctl;
+      break;
+
+    case 2:
+      T1CC2L = LO_UINT16( ticks );
+      T1CC2H = HI_UINT16( ticks );
+      T1CCTL2 = ctl;
+      break;
+
+    case 3:
+      T1CC3L = LO_UINT16( ticks );
+      T1CC3H = HI_UINT16( ticks );
+      T1CCTL3 = ctl;
+      break;
+
+    case 4:
+      T1CC4L = LO_UINT16( ticks );
+      T1CC4H = HI_UINT16( ticks );
+      T1CCTL4 = ctl;
+      break;
+
+    default:
+      break;
+  }
+}
+
+/*********************************************************************
+ * @fn      pulseSelectPin
+ *
+ * @brief   Hand the antenna pin to Timer 1, or back to GPIO. The GPIO
+ *          level is cleared first so the pin is low whenever the timer
+ *          does not own it.
+ *
+ * @param   channel - Timer 1 channel (1-4)
+ * @param   peripheral - TRUE to select the timer output
+ *
+ * @return  none
+ */
+static void pulseSelectPin( uint8 channel, bool peripheral )
+{
+  switch ( channel )
+  {
+    case 1:
+      P1_1 = 0;
+      peripheral ? ( P1SEL |= 0x02 ) : ( P1SEL &= ~0x02 );
+      break;
+
+    case 2:
+      P1_0 = 0;
+      peripheral ? ( P1SEL |= 0x01 ) : ( P1SEL &= ~0x01 );
+      break;
+
+    case 3:
+      P0_7 = 0;
+      peripheral ? ( P0SEL |= 0x80 ) : ( P0SEL &= ~0x80 );
+      break;
+
+    case 4:
+      P0_6 = 0;
+      peripheral ? ( P0SEL |= 0x40 ) : ( P0SEL &= ~0x40 );
+      break;
+
+    default:
+      break;
+  }
+}
+
+/*********************************************************************
+ * @fn      pulseHalt
+ *
+ * @brief   Stop Timer 1 and release the antenna pin. Called with
+ *          interrupts disabled or from the Timer 1 interrupt.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void pulseHalt( void )
+{
+  T1CTL = 0x00;
+  pulseSetCompare( pulseChannel, 0, 0x00 );
+  pulseSelectPin( pulseChannel, FALSE );
+  pulseChannel = ROBOROACH_T1_CHANNEL_NONE;
+}
+
+/*********************************************************************
+ * @fn      roboRoachPulseIsr
+ *
+ * @brief   Timer 1 interrupt: a falling edge has just ended a pulse.
+ *          Commit the pending gain, load the next pulse, a posted retune
+ *          first, or stop after the last one.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+HAL_ISR_FUNCTION( roboRoachPulseIsr, T1_VECTOR )
+{
+  pulseStep_t *pStep;
+
+  // Flags are cleared by writing 0; the module flags before the CPU flag
+  T1STAT = 0x00;
+  T1IF = 0;
+
+  if ( pulseChannel == ROBOROACH_T1_CHANNEL_NONE )
+  {
+    return;
+  }
+
+  pStep = &pulseRing[pulseTail & PULSE_RING_MASK];
+  if ( --pStep->repeat != 0 )
+  {
+    if ( !pulseRetunePosted && !pulseStretched && ( pulseNextGain( pStep ) == pulseGain ) )
+    {
+      // Same shape and gain again; the timer keeps its registers
+      Gain_CommitPending();
+      return;
+    }
+  }
+  else
+  {
+    pulseTail++;
+    if ( PULSE_RING_COUNT() == 0 )
+    {
+      // Either the schedule is complete or the refill fell behind. In both
+      // cases end the train rather than repeat pulses nobody scheduled.
+      pulseHalt();
+      osal_set_event( pulseTaskId, pulseFinishedEvent );
+      return;
+    }
+
+    pStep = &pulseRing[pulseTail & PULSE_RING_MASK];
+  }
+
+  if ( pulseRetunePosted )
+  {
+    // The rest of this step takes the new shape from the next pulse on
+    pulseTakeRetune( pStep );
+  }
+
+  // The pulse is over; the wipers take the gain of the next one in the gap
+  // that was kept for it. A gain not seen coming makes it if the gap does.
+  if ( ( pStep->gain != pulseGain ) && ( pulseGap >= pulseGainGap ) )
+  {
+    pulseGain = pStep->gain;
+    Gain_SetPending( pulseGain );
+  }
+  Gain_CommitPending();
+  pulseLoad( pStep );
+
+  if ( !pulseClosed && ( PULSE_RING_COUNT() <= ROBOROACH_PULSE_RING_LEN / 2 ) )
+  {
+    osal_set_event( pulseTaskId, pulseRefillEvent );
+  }
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,142 @@
+/**************************************************************************************************
+  Filename:       roboRoachPulse.h
+
+  Description:    Hardware pulse engine for the RoboRoach stimulation trains.
+                  Timer 1 runs in modulo mode and drives the antenna pin directly
+                  from a compare channel, so the pulse edges do not depend on the
+                  OSAL scheduler.
+
+  Copyright 2014 Backyard Brains Incorporated. All rights reserved.
+
+**************************************************************************************************/
+
+#ifndef ROBOROACHPULSE_H
+#define ROBOROACHPULSE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Timer 1 compare channel that is not wired to an antenna
+#define ROBOROACH_T1_CHANNEL_NONE           0
+
+// Longest period the engine can generate (Timer 1 at 4us ticks)
+#define ROBOROACH_PULSE_MAX_PERIOD_US       262140UL
+
+// Shortest low time kept between the end of a pulse and the next rising edge
+#define ROBOROACH_PULSE_MIN_GAP_US          50
+
+// Low time kept before a pulse at a new gain: the two wiper writes go out
+// on the SPI after the falling edge (about 70us at 480kHz)
+#define ROBOROACH_PULSE_GAIN_GAP_US         100
+
+// Number of schedule steps buffered ahead of the running pulse (power of 2)
+#define ROBOROACH_PULSE_RING_LEN            16
+
+// Where a train runs, returned by RoboRoachPulse_Open()
+#define ROBOROACH_PULSE_ON_TIMER1           0   // Timer 1 drives the antenna pin
+#define ROBOROACH_PULSE_ON_OSAL             1   // application task, steps in ms
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// One schedule step: repeat pulses of the same shape. Period and width
+// are in timer ticks for Timer 1 trains and in ms for OSAL trains.
+typedef struct
+{
+  uint16 period;
+  uint16 width;
+  uint16 repeat;
+  uint8  gain;
+} pulseStep_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Initialize Timer 1 and register the events posted to the application task
+ */
+extern void RoboRoachPulse_Init( uint8 taskId, uint16 finishedEvent, uint16 refillEvent );
+
+/*
+ * Start a new schedule on a Timer 1 channel (1-4, alternative location 2).
+ * Returns ROBOROACH_PULSE_ON_TIMER1, or ROBOROACH_PULSE_ON_OSAL when the
+ * channel or the longest period can not be generated in hardware.
+ */
+extern uint8 RoboRoachPulse_Open( uint8 channel, uint32 maxPeriodUs );
+
+/*
+ * Append a step to the schedule. Returns FALSE if the ring is full or closed.
+ */
+extern bool RoboRoachPulse_Push( uint32 periodUs, uint32 widthUs, uint8 gain, uint16 repeat );
+
+/*
+ * Replace the rest of the running step with a new shape from the next
+ * pulse on. Lock-free: call from the application task only; the Timer 1
+ * interrupt or RoboRoachPulse_Fetch() takes it at the pulse boundary.
+ */
+extern bool RoboRoachPulse_Retune( uint32 periodUs, uint32 widthUs, uint8 gain, uint16 repeat );
+
+/*
+ * Mark the schedule complete; the train ends after the last pushed step
+ */
+extern void RoboRoachPulse_Close( void );
+
+/*
+ * Free steps in the ring, 0 once the schedule is closed
+ */
+extern uint8 RoboRoachPulse_Space( void );
+
+/*
+ * Start a Timer 1 schedule. The first rising edge is generated as soon as
+ * the wipers hold the gain of the first step.
+ */
+extern uint8 RoboRoachPulse_Go( void );
+
+/*
+ * Take the next pulse of an OSAL schedule. Returns FALSE when none is left.
+ */
+extern bool RoboRoachPulse_Fetch( pulseStep_t *pStep );
+
+/*
+ * Gain of the pulse the next RoboRoachPulse_Fetch() returns, so it can be
+ * written in the gap before. Returns FALSE when no pulse is queued.
+ */
+extern bool RoboRoachPulse_NextGain( uint8 *pGain );
+
+/*
+ * TRUE while the open schedule still has pulses to deliver
+ */
+extern bool RoboRoachPulse_Pending( void );
+
+/*
+ * Halt the engine, drop the schedule, release the antenna pin and the
+ * power manager hold
+ */
+extern void RoboRoachPulse_Stop( void );
+
+/*
+ * TRUE while a hardware train is running
+ */
+extern bool RoboRoachPulse_IsActive( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROBOROACHPULSE_H */
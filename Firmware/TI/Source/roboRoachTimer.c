@@ -0,0 +1,147 @@
+/**************************************************************************************************
+  Filename:       roboRoachTimer.c
+
+  Description:    Registry of the application task's OSAL timers.
+
+                  Every timer of the application task is armed through
+                  RoboRoachTimer_Start(), which keeps a mask of the events
+                  that may still have a timer. A fired timer leaves its bit
+                  set until RoboRoachTimer_Active() finds no timeout for it.
+                  RoboRoachTimer_CancelAll() stops everything in the mask, so
+                  sleep entry does not depend on knowing which timers are up.
+
+  Copyright 2014 Backyard Brains Incorporated. All rights reserved.
+
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "OSAL.h"
+#include "OSAL_Timers.h"
+
+#include "roboRoachTimer.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Task event bits that can carry a timer; 0x8000 is SYS_EVENT_MSG
+#define TIMER_EVENT_BITS            0x7FFF
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint8  timerTaskId;
+static uint16 timerArmed = 0;      // events that may have a timer running
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      RoboRoachTimer_Init
+ *
+ * @brief   Register the task whose timers are tracked.
+ *
+ * @param   taskId - application task
+ *
+ * @return  none
+ */
+void RoboRoachTimer_Init( uint8 taskId )
+{
+  timerTaskId = taskId;
+  timerArmed = 0;
+}
+
+/*********************************************************************
+ * @fn      RoboRoachTimer_Start
+ *
+ * @brief   Arm the timer of one event, replacing any running one.
+ *
+ * @param   event - task event to set when the timer expires
+ * @param   timeout - ms until it expires
+ *
+ * @return  none
+ */
+void RoboRoachTimer_Start( uint16 event, uint32 timeout )
+{
+  if ( osal_start_timerEx( timerTaskId, event, timeout ) == SUCCESS )
+  {
+    timerArmed |= event;
+  }
+}
+
+/*********************************************************************
+ * @fn      RoboRoachTimer_Stop
+ *
+ * @brief   Disarm the timers of the given events. Events that already
+ *          fired are not cleared.
+ *
+ * @param   events - task event bits
+ *
+ * @return  none
+ */
+void RoboRoachTimer_Stop( uint16 events )
+{
+  uint16 pending = events & timerArmed;
+  uint16 bit;
+
+  for ( bit = 0x0001; pending; bit <<= 1 )
+  {
+    if ( pending & bit )
+    {
+      VOID osal_stop_timerEx( timerTaskId, bit );
+      pending &= ~bit;
+    }
+  }
+  timerArmed &= ~events;
+}
+
+/*********************************************************************
+ * @fn      RoboRoachTimer_CancelAll
+ *
+ * @brief   Disarm every tracked timer and clear the events they set
+ *          before this call, so nothing of the task is left to run.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void RoboRoachTimer_CancelAll( void )
+{
+  uint16 armed = timerArmed;
+
+  RoboRoachTimer_Stop( armed );
+  timerArmed = 0;
+  VOID osal_clear_event( timerTaskId, armed & TIMER_EVENT_BITS );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachTimer_Active
+ *
+ * @brief   List the events whose timers are still armed. Timers that
+ *          have fired are dropped from the registry here.
+ *
+ * @param   none
+ *
+ * @return  mask of task events with a running timer
+ */
+uint16 RoboRoachTimer_Active( void )
+{
+  uint16 bit;
+
+  for ( bit = 0x0001; bit & TIMER_EVENT_BITS; bit <<= 1 )
+  {
+    if ( ( timerArmed & bit ) && ( osal_get_timeoutEx( timerTaskId, bit ) == 0 ) )
+    {
+      timerArmed &= ~bit;
+    }
+  }
+
+  return ( timerArmed );
+}
+
+/*********************************************************************
+*********************************************************************/
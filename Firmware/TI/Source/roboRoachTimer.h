@@ -0,0 +1,60 @@
+/**************************************************************************************************
+  Filename:       roboRoachTimer.h
+
+  Description:    Registry of the OSAL timers armed for the application task,
+                  so they can be listed and cancelled together before sleep.
+
+  Copyright 2014 Backyard Brains Incorporated. All rights reserved.
+
+**************************************************************************************************/
+
+#ifndef ROBOROACHTIMER_H
+#define ROBOROACHTIMER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_types.h"
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Register the task whose timers are tracked
+ */
+extern void RoboRoachTimer_Init( uint8 taskId );
+
+/*
+ * Arm (or re-arm) the timer of one event, timeout in ms
+ */
+extern void RoboRoachTimer_Start( uint16 event, uint32 timeout );
+
+/*
+ * Disarm the timers of the given events
+ */
+extern void RoboRoachTimer_Stop( uint16 events );
+
+/*
+ * Disarm every tracked timer and clear the events they already set
+ */
+extern void RoboRoachTimer_CancelAll( void );
+
+/*
+ * Events whose timers are still armed
+ */
+extern uint16 RoboRoachTimer_Active( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROBOROACHTIMER_H */
@@ -11,6 +11,7 @@
  */
 #include "bcomdef.h"
 #include "OSAL.h"
+#include "osal_snv.h"
 #include "linkdb.h"
 #include "att.h"
 #include "gatt.h"
@@ -22,6 +23,7 @@
 
 #include "roboRoach.h"
 #include "roboroach_GATTprofile.h"
+#include "roboRoachLatency.h"
 
 /*********************************************************************
  * MACROS
@@ -31,7 +33,19 @@
  * CONSTANTS
  */
 
-#define SERVAPP_NUM_ATTR_SUPPORTED      40  
+#if defined ( ROBOROACH_EVENT_STATS )
+  #define SERVAPP_NUM_EVENT_STATS_ATTR  3
+#else
+  #define SERVAPP_NUM_EVENT_STATS_ATTR  0
+#endif
+
+#if defined ( ROBOROACH_LATENCY_STATS )
+  #define SERVAPP_NUM_LATENCY_ATTR      3
+#else
+  #define SERVAPP_NUM_LATENCY_ATTR      0
+#endif
+
+#define SERVAPP_NUM_ATTR_SUPPORTED      ( 65 + SERVAPP_NUM_EVENT_STATS_ATTR + SERVAPP_NUM_LATENCY_ATTR )
 
 /*********************************************************************
  * TYPEDEFS
@@ -131,6 +145,70 @@ CONST uint8 rrCharGainMaxUUID[ATT_BT_UUID_SIZE] =
   LO_UINT16(ROBOROACH_CHAR_GAIN_MAX_UUID), HI_UINT16(ROBOROACH_CHAR_GAIN_MAX_UUID)
 };
 
+// Stimulation Config Characteristic UUID: 0xB2BE
+CONST uint8 rrCharConfigUUID[ATT_BT_UUID_SIZE] =
+{ 
+  LO_UINT16(ROBOROACH_CHAR_CONFIG_UUID), HI_UINT16(ROBOROACH_CHAR_CONFIG_UUID)
+};
+
+// Pulse Width in Microseconds Characteristic UUID: 0xB2C0
+CONST uint8 rrCharPulseWidthUsUUID[ATT_BT_UUID_SIZE] =
+{ 
+  LO_UINT16(ROBOROACH_CHAR_PULSE_WIDTH_US_UUID), HI_UINT16(ROBOROACH_CHAR_PULSE_WIDTH_US_UUID)
+};
+
+// Period in Microseconds Characteristic UUID: 0xB2C1
+CONST uint8 rrCharPeriodUsUUID[ATT_BT_UUID_SIZE] =
+{ 
+  LO_UINT16(ROBOROACH_CHAR_PERIOD_US_UUID), HI_UINT16(ROBOROACH_CHAR_PERIOD_US_UUID)
+};
+
+// Command Policy Characteristic UUID: 0xB2C2
+CONST uint8 rrCharCommandPolicyUUID[ATT_BT_UUID_SIZE] =
+{ 
+  LO_UINT16(ROBOROACH_CHAR_COMMAND_POLICY_UUID), HI_UINT16(ROBOROACH_CHAR_COMMAND_POLICY_UUID)
+};
+
+// Live Update Characteristic UUID: 0xB2C6
+CONST uint8 rrCharLiveUpdateUUID[ATT_BT_UUID_SIZE] =
+{ 
+  LO_UINT16(ROBOROACH_CHAR_LIVE_UPDATE_UUID), HI_UINT16(ROBOROACH_CHAR_LIVE_UPDATE_UUID)
+};
+
+// Preset Upload Characteristic UUID: 0xB2C7
+CONST uint8 rrCharPresetUploadUUID[ATT_BT_UUID_SIZE] =
+{ 
+  LO_UINT16(ROBOROACH_CHAR_PRESET_UPLOAD_UUID), HI_UINT16(ROBOROACH_CHAR_PRESET_UPLOAD_UUID)
+};
+
+// Active Preset Characteristic UUID: 0xB2C8
+CONST uint8 rrCharActivePresetUUID[ATT_BT_UUID_SIZE] =
+{ 
+  LO_UINT16(ROBOROACH_CHAR_ACTIVE_PRESET_UUID), HI_UINT16(ROBOROACH_CHAR_ACTIVE_PRESET_UUID)
+};
+
+// Stimulation Status Characteristic UUID: 0xB2C3
+CONST uint8 rrCharStatusUUID[ATT_BT_UUID_SIZE] =
+{ 
+  LO_UINT16(ROBOROACH_CHAR_STATUS_UUID), HI_UINT16(ROBOROACH_CHAR_STATUS_UUID)
+};
+
+#if defined ( ROBOROACH_EVENT_STATS )
+// Event Statistics Characteristic UUID: 0xB2C4
+CONST uint8 rrCharEventStatsUUID[ATT_BT_UUID_SIZE] =
+{ 
+  LO_UINT16(ROBOROACH_CHAR_EVENT_STATS_UUID), HI_UINT16(ROBOROACH_CHAR_EVENT_STATS_UUID)
+};
+#endif
+
+#if defined ( ROBOROACH_LATENCY_STATS )
+// Latency Statistics Characteristic UUID: 0xB2C5
+CONST uint8 rrCharLatencyUUID[ATT_BT_UUID_SIZE] =
+{ 
+  LO_UINT16(ROBOROACH_CHAR_LATENCY_UUID), HI_UINT16(ROBOROACH_CHAR_LATENCY_UUID)
+};
+#endif
+
 
 /*********************************************************************
  * EXTERNAL VARIABLES
@@ -146,6 +224,12 @@ CONST uint8 rrCharGainMaxUUID[ATT_BT_UUID_SIZE] =
 
 static roboRoachProfileCBs_t *roboRoach_AppCBs = NULL;
 
+// Stimulate commands not yet taken by the application, oldest first. With
+// writes without response several can arrive in one connection event.
+static uint8 rrCommandInbox[ROBOROACH_COMMAND_INBOX_LEN];
+static uint8 rrCommandInboxHead = 0;
+static uint8 rrCommandInboxCount = 0;
+
 /*********************************************************************
  * Profile Attributes - variables
  */
@@ -179,12 +263,12 @@ static uint8 rrCharRandomMode = 0; //Default: Off
 static uint8 rrCharRandomModeUserDesp[24] = "Random Mode (enabled=1)\0";
 
 // Stimulate Left Characteristic Properties
-static uint8 rrCharStimulateLeftProps = GATT_PROP_WRITE; //GATT_PROP_NOTIFY;
+static uint8 rrCharStimulateLeftProps = GATT_PROP_WRITE | GATT_PROP_WRITE_NO_RSP; //GATT_PROP_NOTIFY;
 static uint8 rrCharStimulateLeft = 0;
 static uint8 rrCharStimulateLeftUserDesp[15] = "Stimulate Left\0";
 
 // Stimulate Right Characteristic Properties
-static uint8 rrCharStimulateRightProps = GATT_PROP_WRITE; //GATT_PROP_NOTIFY;
+static uint8 rrCharStimulateRightProps = GATT_PROP_WRITE | GATT_PROP_WRITE_NO_RSP; //GATT_PROP_NOTIFY;
 static uint8 rrCharStimulateRight = 0;
 static uint8 rrCharStimulateRightUserDesp[16] = "Stimulate Right\0";
 
@@ -218,6 +302,61 @@ static uint8 rrCharGainMaxProps = GATT_PROP_READ | GATT_PROP_WRITE; //GATT_PROP_
 static uint8 rrCharGainMax = 50;  //Default: 50%
 static uint8 rrCharGainMaxUserDesp[13] = "Maximum Gain\0";
 
+// Stimulation Config Characteristic Properties (value is packed on read)
+static uint8 rrCharConfigProps = GATT_PROP_READ | GATT_PROP_WRITE;
+static uint8 rrCharConfig = 0;
+static uint8 rrCharConfigUserDesp[19] = "Stimulation Config\0";
+
+// Pulse Width in Microseconds Characteristic Properties
+static uint8 rrCharPulseWidthUsProps = GATT_PROP_READ | GATT_PROP_WRITE;
+static uint16 rrCharPulseWidthUs = 0;  //Default: 0 = use the ms Pulse Width
+static uint8 rrCharPulseWidthUsUserDesp[23] = "Pulse Width (us), 0=ms\0";
+
+// Period in Microseconds Characteristic Properties
+static uint8 rrCharPeriodUsProps = GATT_PROP_READ | GATT_PROP_WRITE;
+static uint16 rrCharPeriodUs = 0;  //Default: 0 = use the Frequency
+static uint8 rrCharPeriodUsUserDesp[25] = "Period (us), 0=Frequency\0";
+
+// Command Policy Characteristic Properties
+static uint8 rrCharCommandPolicyProps = GATT_PROP_READ | GATT_PROP_WRITE;
+static uint8 rrCharCommandPolicy = ROBOROACH_POLICY_DROP;  //Default: ignore commands during a train
+static uint8 rrCharCommandPolicyUserDesp[47] = "Command Policy (0=drop,1=fifo,2=latest,3=swap)\0";
+
+// Live Update Characteristic Properties
+static uint8 rrCharLiveUpdateProps = GATT_PROP_READ | GATT_PROP_WRITE;
+static uint8 rrCharLiveUpdate = 0;  //Default: Off, writes wait for the next train
+static uint8 rrCharLiveUpdateUserDesp[35] = "Live Parameter Updates (enabled=1)\0";
+
+// Preset Upload Characteristic Properties (value goes to SNV)
+static uint8 rrCharPresetUploadProps = GATT_PROP_WRITE;
+static uint8 rrCharPresetUpload = 0;
+static uint8 rrCharPresetUploadUserDesp[29] = "Preset Upload (slot, config)\0";
+
+// Active Preset Characteristic Properties
+static uint8 rrCharActivePresetProps = GATT_PROP_READ | GATT_PROP_WRITE;
+static uint8 rrCharActivePreset = ROBOROACH_PRESET_NONE;
+static uint8 rrCharActivePresetUserDesp[14] = "Active Preset\0";
+
+// Stimulation Status Characteristic Properties
+static uint8 rrCharStatusProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
+static uint8 rrCharStatus[ROBOROACH_STATUS_LEN] = { 0, ROBOROACH_STATUS_IDLE, 0, 0 };
+static gattCharCfg_t rrCharStatusConfig[GATT_MAX_NUM_CONN];
+static uint8 rrCharStatusUserDesp[19] = "Stimulation Status\0";
+
+#if defined ( ROBOROACH_EVENT_STATS )
+// Event Statistics Characteristic Properties (value comes from the application)
+static uint8 rrCharEventStatsProps = GATT_PROP_READ | GATT_PROP_WRITE;
+static uint8 rrCharEventStats = 0;
+static uint8 rrCharEventStatsUserDesp[31] = "Event Statistics (write=clear)\0";
+#endif
+
+#if defined ( ROBOROACH_LATENCY_STATS )
+// Latency Statistics Characteristic (long read, filled by roboRoachLatency.c)
+static uint8 rrCharLatencyProps = GATT_PROP_READ | GATT_PROP_WRITE;
+static uint8 rrCharLatency = 0;
+static uint8 rrCharLatencyUserDesp[33] = "Latency Statistics (write=clear)\0";
+#endif
+
 
 /*********************************************************************
  * Profile Attributes - Table
@@ -297,6 +436,61 @@ static gattAttribute_t roboRoachAttrTbl[SERVAPP_NUM_ATTR_SUPPORTED] =
     {{ ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &rrCharGainMaxProps },
     {{ ATT_BT_UUID_SIZE, rrCharGainMaxUUID }, GATT_PERMIT_READ | GATT_PERMIT_WRITE, 0, &rrCharGainMax },
     {{ ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, rrCharGainMaxUserDesp }, 
+
+    // Stimulation Config Characteristic Declaration
+    {{ ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &rrCharConfigProps },
+    {{ ATT_BT_UUID_SIZE, rrCharConfigUUID }, GATT_PERMIT_READ | GATT_PERMIT_WRITE, 0, &rrCharConfig },
+    {{ ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, rrCharConfigUserDesp }, 
+
+    // Pulse Width in Microseconds Characteristic Declaration
+    {{ ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &rrCharPulseWidthUsProps },
+    {{ ATT_BT_UUID_SIZE, rrCharPulseWidthUsUUID }, GATT_PERMIT_READ | GATT_PERMIT_WRITE, 0, (uint8 *)&rrCharPulseWidthUs },
+    {{ ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, rrCharPulseWidthUsUserDesp }, 
+
+    // Period in Microseconds Characteristic Declaration
+    {{ ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &rrCharPeriodUsProps },
+    {{ ATT_BT_UUID_SIZE, rrCharPeriodUsUUID }, GATT_PERMIT_READ | GATT_PERMIT_WRITE, 0, (uint8 *)&rrCharPeriodUs },
+    {{ ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, rrCharPeriodUsUserDesp }, 
+
+    // Command Policy Characteristic Declaration
+    {{ ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &rrCharCommandPolicyProps },
+    {{ ATT_BT_UUID_SIZE, rrCharCommandPolicyUUID }, GATT_PERMIT_READ | GATT_PERMIT_WRITE, 0, &rrCharCommandPolicy },
+    {{ ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, rrCharCommandPolicyUserDesp }, 
+
+    // Live Update Characteristic Declaration
+    {{ ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &rrCharLiveUpdateProps },
+    {{ ATT_BT_UUID_SIZE, rrCharLiveUpdateUUID }, GATT_PERMIT_READ | GATT_PERMIT_WRITE, 0, &rrCharLiveUpdate },
+    {{ ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, rrCharLiveUpdateUserDesp }, 
+
+    // Preset Upload Characteristic Declaration
+    {{ ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &rrCharPresetUploadProps },
+    {{ ATT_BT_UUID_SIZE, rrCharPresetUploadUUID }, GATT_PERMIT_WRITE, 0, &rrCharPresetUpload },
+    {{ ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, rrCharPresetUploadUserDesp }, 
+
+    // Active Preset Characteristic Declaration
+    {{ ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &rrCharActivePresetProps },
+    {{ ATT_BT_UUID_SIZE, rrCharActivePresetUUID }, GATT_PERMIT_READ | GATT_PERMIT_WRITE, 0, &rrCharActivePreset },
+    {{ ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, rrCharActivePresetUserDesp }, 
+
+    // Stimulation Status Characteristic Declaration
+    {{ ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &rrCharStatusProps },
+    {{ ATT_BT_UUID_SIZE, rrCharStatusUUID }, GATT_PERMIT_READ, 0, rrCharStatus },
+    {{ ATT_BT_UUID_SIZE, clientCharCfgUUID }, GATT_PERMIT_READ | GATT_PERMIT_WRITE, 0, (uint8 *)rrCharStatusConfig },
+    {{ ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, rrCharStatusUserDesp }, 
+
+#if defined ( ROBOROACH_EVENT_STATS )
+    // Event Statistics Characteristic Declaration
+    {{ ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &rrCharEventStatsProps },
+    {{ ATT_BT_UUID_SIZE, rrCharEventStatsUUID }, GATT_PERMIT_READ | GATT_PERMIT_WRITE, 0, &rrCharEventStats },
+    {{ ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, rrCharEventStatsUserDesp }, 
+#endif
+
+#if defined ( ROBOROACH_LATENCY_STATS )
+    // Latency Statistics Characteristic Declaration
+    {{ ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &rrCharLatencyProps },
+    {{ ATT_BT_UUID_SIZE, rrCharLatencyUUID }, GATT_PERMIT_READ | GATT_PERMIT_WRITE, 0, &rrCharLatency },
+    {{ ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, rrCharLatencyUserDesp }, 
+#endif
     
 };
 
@@ -312,6 +506,10 @@ static bStatus_t roboRoachProfile_WriteAttrCB( uint16 connHandle, gattAttribute_
 static void roboRoachProfile_HandleConnStatusCB( uint16 connHandle, uint8 changeType );
 
 static void roboRoachProfile_updateStimulationSettings( void );
+static void roboRoachProfile_PackConfig( uint8 *pValue );
+static bStatus_t roboRoachProfile_UnpackConfig( uint8 *pValue, uint8 len );
+static bStatus_t roboRoachProfile_UploadPreset( uint8 *pValue, uint8 len );
+static bStatus_t roboRoachProfile_LoadPreset( uint8 slot );
 static void roboRoachProfile_Stimulate( uint16 uuid );
  
 /*********************************************************************
@@ -346,7 +544,7 @@ bStatus_t RoboRoachProfile_AddService( uint8 taskID )
   roboRoachApp_TaskID = taskID;
 
   // Initialize Client Characteristic Configuration attributes
-  //GATTServApp_InitCharCfg( INVALID_CONNHANDLE, rrCharStimulateLeftConfig );
+  GATTServApp_InitCharCfg( INVALID_CONNHANDLE, rrCharStatusConfig );
 
   // Register with Link DB to receive link status change callback
   VOID linkDB_Register( roboRoachProfile_HandleConnStatusCB );  
@@ -550,6 +748,67 @@ bStatus_t RoboRoachProfile_SetParameter( uint8 param, uint8 len, void *value )
         ret = bleInvalidRange;
       }
       break;
+
+    case ROBOROACH_PULSE_WIDTH_US:
+      if ( len == sizeof ( uint16 ) ) 
+      {
+        rrCharPulseWidthUs = *((uint16*)value);
+        roboRoachProfile_updateStimulationSettings();
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    case ROBOROACH_PERIOD_US:
+      if ( len == sizeof ( uint16 ) ) 
+      {
+        rrCharPeriodUs = *((uint16*)value);
+        roboRoachProfile_updateStimulationSettings();
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    case ROBOROACH_COMMAND_POLICY:
+      if ( len == sizeof ( uint8 ) ) 
+      {
+        rrCharCommandPolicy = *((uint8*)value);
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    case ROBOROACH_LIVE_UPDATE:
+      if ( len == sizeof ( uint8 ) ) 
+      {
+        rrCharLiveUpdate = *((uint8*)value);
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    case ROBOROACH_ACTIVE_PRESET:
+      if ( ( len != sizeof ( uint8 ) ) ||
+           ( roboRoachProfile_LoadPreset( *((uint8*)value) ) != SUCCESS ) )
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    case ROBOROACH_CONFIG:
+      if ( roboRoachProfile_UnpackConfig( (uint8*)value, len ) != SUCCESS )
+      {
+        ret = bleInvalidRange;
+      }
+      break;
       
     default:
       ret = INVALIDPARAMETER;
@@ -624,6 +883,34 @@ bStatus_t RoboRoachProfile_GetParameter( uint8 param, void *value )
     case ROBOROACH_GAIN_MAX:
       *((uint8*)value) = rrCharGainMax;
       break;        
+
+    case ROBOROACH_PULSE_WIDTH_US:
+      *((uint16*)value) = rrCharPulseWidthUs;
+      break;
+
+    case ROBOROACH_PERIOD_US:
+      *((uint16*)value) = rrCharPeriodUs;
+      break;
+
+    case ROBOROACH_COMMAND_POLICY:
+      *((uint8*)value) = rrCharCommandPolicy;
+      break;
+
+    case ROBOROACH_LIVE_UPDATE:
+      *((uint8*)value) = rrCharLiveUpdate;
+      break;
+
+    case ROBOROACH_ACTIVE_PRESET:
+      *((uint8*)value) = rrCharActivePreset;
+      break;
+
+    case ROBOROACH_CONFIG:
+      roboRoachProfile_PackConfig( (uint8*)value );
+      break;
+
+    case ROBOROACH_STATUS:
+      VOID osal_memcpy( value, rrCharStatus, ROBOROACH_STATUS_LEN );
+      break;
       
     default:
       ret = INVALIDPARAMETER;
@@ -633,6 +920,34 @@ bStatus_t RoboRoachProfile_GetParameter( uint8 param, void *value )
   return ( ret );
 }
 
+/*********************************************************************
+ * @fn      RoboRoachProfile_GetParams
+ *
+ * @brief   Copy every stimulation parameter in one call, so the
+ *          application gets a set from a single state of the profile
+ *          instead of thirteen reads.
+ *
+ * @param   pParams - filled with the current characteristic values
+ *
+ * @return  none
+ */
+void RoboRoachProfile_GetParams( roboRoachParams_t *pParams )
+{
+  pParams->periodMs = stimulationPeriodInMilliseconds;
+  pParams->periodUs = rrCharPeriodUs;
+  pParams->pulseWidthUs = rrCharPulseWidthUs;
+  pParams->pulseWidth = rrCharPulseWidth;
+  pParams->duration = rrCharDurationIn5msIncrements;
+  pParams->randomMode = rrCharRandomMode;
+  pParams->gain = rrCharGain;
+  pParams->freqMin = rrCharFreqMin;
+  pParams->freqMax = rrCharFreqMax;
+  pParams->pwMin = rrCharPWmin;
+  pParams->pwMax = rrCharPWmax;
+  pParams->gainMin = rrCharGainMin;
+  pParams->gainMax = rrCharGainMax;
+}
+
 /*********************************************************************
  * @fn          roboRoachProfile_ReadAttrCB
  *
@@ -659,16 +974,39 @@ static uint8 roboRoachProfile_ReadAttrCB( uint16 connHandle, gattAttribute_t *pA
     return ( ATT_ERR_INSUFFICIENT_AUTHOR );
   }
   
-  // Make sure it's not a blob operation (no attributes in the profile are long)
-  if ( offset > 0 )
-  {
-    return ( ATT_ERR_ATTR_NOT_LONG );
-  }
- 
   if ( pAttr->type.len == ATT_BT_UUID_SIZE )
   {
     // 16-bit UUID
     uint16 uuid = BUILD_UINT16( pAttr->type.uuid[0], pAttr->type.uuid[1]);
+
+#if defined ( ROBOROACH_EVENT_STATS )
+    // A long attribute: the application fills it from any offset
+    if ( uuid == ROBOROACH_CHAR_EVENT_STATS_UUID )
+    {
+      *pLen = 0;
+      if ( roboRoach_AppCBs && roboRoach_AppCBs->pfnRoboRoachProfileReadStats )
+      {
+        *pLen = roboRoach_AppCBs->pfnRoboRoachProfileReadStats( pValue, offset, maxLen );
+      }
+      return ( SUCCESS );
+    }
+#endif
+
+#if defined ( ROBOROACH_LATENCY_STATS )
+    // Also long, filled from any offset
+    if ( uuid == ROBOROACH_CHAR_LATENCY_UUID )
+    {
+      *pLen = RoboRoachLatency_Read( pValue, offset, maxLen );
+      return ( SUCCESS );
+    }
+#endif
+
+    // Make sure it's not a blob operation (no other attributes in the profile are long)
+    if ( offset > 0 )
+    {
+      return ( ATT_ERR_ATTR_NOT_LONG );
+    }
+
     switch ( uuid )
     {
       // No need for "GATT_SERVICE_UUID" or "GATT_CLIENT_CHAR_CFG_UUID" cases;
@@ -686,10 +1024,31 @@ static uint8 roboRoachProfile_ReadAttrCB( uint16 connHandle, gattAttribute_t *pA
       case ROBOROACH_CHAR_PW_MAX_UUID:
       case ROBOROACH_CHAR_GAIN_MIN_UUID:
       case ROBOROACH_CHAR_GAIN_MAX_UUID: 
+      case ROBOROACH_CHAR_COMMAND_POLICY_UUID:
+      case ROBOROACH_CHAR_LIVE_UPDATE_UUID:
+      case ROBOROACH_CHAR_ACTIVE_PRESET_UUID:
       
         *pLen = 1;
         pValue[0] = *pAttr->pValue;
         break;
+
+      // Microsecond characteristics are 16 bits, little endian
+      case ROBOROACH_CHAR_PULSE_WIDTH_US_UUID:
+      case ROBOROACH_CHAR_PERIOD_US_UUID:
+        *pLen = 2;
+        pValue[0] = LO_UINT16( *((uint16 *)pAttr->pValue) );
+        pValue[1] = HI_UINT16( *((uint16 *)pAttr->pValue) );
+        break;
+
+      case ROBOROACH_CHAR_CONFIG_UUID:
+        *pLen = ROBOROACH_CONFIG_LEN;
+        roboRoachProfile_PackConfig( pValue );
+        break;
+
+      case ROBOROACH_CHAR_STATUS_UUID:
+        *pLen = ROBOROACH_STATUS_LEN;
+        VOID osal_memcpy( pValue, pAttr->pValue, ROBOROACH_STATUS_LEN );
+        break;
   
       default:
         // Should never get here! (Stimulation characteristics do not have read permissions)
@@ -755,6 +1114,8 @@ static bStatus_t roboRoachProfile_WriteAttrCB( uint16 connHandle, gattAttribute_
       case ROBOROACH_CHAR_PW_MAX_UUID:
       case ROBOROACH_CHAR_GAIN_MIN_UUID:
       case ROBOROACH_CHAR_GAIN_MAX_UUID: 
+      case ROBOROACH_CHAR_COMMAND_POLICY_UUID:
+      case ROBOROACH_CHAR_LIVE_UPDATE_UUID:
       
         //Validate the value (Make sure it's not a blob oper)
         if ( offset == 0 )
@@ -777,11 +1138,102 @@ static bStatus_t roboRoachProfile_WriteAttrCB( uint16 connHandle, gattAttribute_
           
           //Update the Stim Values
           roboRoachProfile_updateStimulationSettings();
-      
+
+          if ( ( uuid != ROBOROACH_CHAR_COMMAND_POLICY_UUID ) &&
+               ( uuid != ROBOROACH_CHAR_LIVE_UPDATE_UUID ) )
+          {
+            notifyApp = ROBOROACH_PARAMS;
+          }
         }
                      
         break;
+
+      case ROBOROACH_CHAR_PULSE_WIDTH_US_UUID:
+      case ROBOROACH_CHAR_PERIOD_US_UUID:
+
+        //Validate the value (Make sure it's not a blob oper)
+        if ( offset == 0 )
+        {
+          if ( len != 2 )
+          {
+            status = ATT_ERR_INVALID_VALUE_SIZE;
+          }
+        }
+        else
+        {
+          status = ATT_ERR_ATTR_NOT_LONG;
+        }
+
+        //Write the value
+        if ( status == SUCCESS )
+        {
+          uint16 *pCurValue = (uint16 *)pAttr->pValue;
+          *pCurValue = BUILD_UINT16( pValue[0], pValue[1] );
+
+          //Update the Stim Values
+          roboRoachProfile_updateStimulationSettings();
+          notifyApp = ROBOROACH_PARAMS;
+        }
+
+        break;
         
+      case ROBOROACH_CHAR_CONFIG_UUID:
+
+        //One write sets every parameter (Make sure it's not a blob oper)
+        if ( offset == 0 )
+        {
+          status = roboRoachProfile_UnpackConfig( pValue, len );
+          if ( status == SUCCESS )
+          {
+            notifyApp = ROBOROACH_PARAMS;
+          }
+        }
+        else
+        {
+          status = ATT_ERR_ATTR_NOT_LONG;
+        }
+
+        break;
+
+      case ROBOROACH_CHAR_PRESET_UPLOAD_UUID:
+
+        //Stored as is, nothing changes until the slot is selected
+        if ( offset == 0 )
+        {
+          status = roboRoachProfile_UploadPreset( pValue, len );
+        }
+        else
+        {
+          status = ATT_ERR_ATTR_NOT_LONG;
+        }
+
+        break;
+
+      case ROBOROACH_CHAR_ACTIVE_PRESET_UUID:
+
+        //One byte loads a whole parameter set
+        if ( offset == 0 )
+        {
+          if ( len != 1 )
+          {
+            status = ATT_ERR_INVALID_VALUE_SIZE;
+          }
+          else
+          {
+            status = roboRoachProfile_LoadPreset( pValue[0] );
+          }
+          if ( status == SUCCESS )
+          {
+            notifyApp = ROBOROACH_PARAMS;
+          }
+        }
+        else
+        {
+          status = ATT_ERR_ATTR_NOT_LONG;
+        }
+
+        break;
+
       case ROBOROACH_CHAR_STIMULATE_LEFT_UUID :
       case ROBOROACH_CHAR_STIMULATE_RIGHT_UUID :
      
@@ -806,6 +1258,38 @@ static bStatus_t roboRoachProfile_WriteAttrCB( uint16 connHandle, gattAttribute_
                      
         break;
         
+#if defined ( ROBOROACH_EVENT_STATS )
+      case ROBOROACH_CHAR_EVENT_STATS_UUID:
+
+        //Any value clears the statistics
+        if ( offset == 0 )
+        {
+          notifyApp = ROBOROACH_EVENT_STATS_RESET;
+        }
+        else
+        {
+          status = ATT_ERR_ATTR_NOT_LONG;
+        }
+
+        break;
+#endif
+
+#if defined ( ROBOROACH_LATENCY_STATS )
+      case ROBOROACH_CHAR_LATENCY_UUID:
+
+        //Any value clears the statistics
+        if ( offset == 0 )
+        {
+          RoboRoachLatency_Reset();
+        }
+        else
+        {
+          status = ATT_ERR_ATTR_NOT_LONG;
+        }
+
+        break;
+#endif
+
       case GATT_CLIENT_CHAR_CFG_UUID:
         status = GATTServApp_ProcessCCCWriteReq( connHandle, pAttr, pValue, len,
                                                  offset, GATT_CLIENT_CFG_NOTIFY );
@@ -816,6 +1300,12 @@ static bStatus_t roboRoachProfile_WriteAttrCB( uint16 connHandle, gattAttribute_
         status = ATT_ERR_ATTR_NOT_FOUND;
         break;
     }
+
+    //Any other parameter write leaves the preset behind
+    if ( ( notifyApp == ROBOROACH_PARAMS ) && ( uuid != ROBOROACH_CHAR_ACTIVE_PRESET_UUID ) )
+    {
+      rrCharActivePreset = ROBOROACH_PRESET_NONE;
+    }
   }
   else
   {
@@ -878,6 +1368,184 @@ static void roboRoachProfile_updateStimulationSettings( void )
 }
 
 
+/*********************************************************************
+ * @fn          roboRoachProfile_PackConfig
+ *
+ * @brief       Build the Stimulation Config value from the individual
+ *              characteristics.
+ *
+ * @param       pValue - ROBOROACH_CONFIG_LEN bytes to fill
+ *
+ * @return      none
+ */
+static void roboRoachProfile_PackConfig( uint8 *pValue )
+{
+  pValue[ROBOROACH_CONFIG_OFS_VERSION] = ROBOROACH_CONFIG_VERSION;
+  pValue[ROBOROACH_CONFIG_OFS_FREQUENCY] = rrCharFrequency;
+  pValue[ROBOROACH_CONFIG_OFS_PULSE_WIDTH] = rrCharPulseWidth;
+  pValue[ROBOROACH_CONFIG_OFS_DURATION] = rrCharDurationIn5msIncrements;
+  pValue[ROBOROACH_CONFIG_OFS_RANDOM_MODE] = rrCharRandomMode;
+  pValue[ROBOROACH_CONFIG_OFS_GAIN] = rrCharGain;
+  pValue[ROBOROACH_CONFIG_OFS_FREQ_MIN] = rrCharFreqMin;
+  pValue[ROBOROACH_CONFIG_OFS_FREQ_MAX] = rrCharFreqMax;
+  pValue[ROBOROACH_CONFIG_OFS_PW_MIN] = rrCharPWmin;
+  pValue[ROBOROACH_CONFIG_OFS_PW_MAX] = rrCharPWmax;
+  pValue[ROBOROACH_CONFIG_OFS_GAIN_MIN] = rrCharGainMin;
+  pValue[ROBOROACH_CONFIG_OFS_GAIN_MAX] = rrCharGainMax;
+  pValue[ROBOROACH_CONFIG_OFS_PULSE_WIDTH_US] = LO_UINT16( rrCharPulseWidthUs );
+  pValue[ROBOROACH_CONFIG_OFS_PULSE_WIDTH_US + 1] = HI_UINT16( rrCharPulseWidthUs );
+  pValue[ROBOROACH_CONFIG_OFS_PERIOD_US] = LO_UINT16( rrCharPeriodUs );
+  pValue[ROBOROACH_CONFIG_OFS_PERIOD_US + 1] = HI_UINT16( rrCharPeriodUs );
+}
+
+/*********************************************************************
+ * @fn          roboRoachProfile_UnpackConfig
+ *
+ * @brief       Apply a Stimulation Config value. Either every parameter
+ *              is taken or, if the value is rejected, none is.
+ *
+ * @param       pValue - packed parameters
+ * @param       len - length of pValue
+ *
+ * @return      SUCCESS, ATT_ERR_INVALID_VALUE_SIZE or ATT_ERR_INVALID_VALUE
+ *              (unknown version)
+ */
+static bStatus_t roboRoachProfile_UnpackConfig( uint8 *pValue, uint8 len )
+{
+  if ( len != ROBOROACH_CONFIG_LEN )
+  {
+    return ( ATT_ERR_INVALID_VALUE_SIZE );
+  }
+  if ( pValue[ROBOROACH_CONFIG_OFS_VERSION] != ROBOROACH_CONFIG_VERSION )
+  {
+    return ( ATT_ERR_INVALID_VALUE );
+  }
+
+  rrCharFrequency = pValue[ROBOROACH_CONFIG_OFS_FREQUENCY];
+  rrCharPulseWidth = pValue[ROBOROACH_CONFIG_OFS_PULSE_WIDTH];
+  rrCharDurationIn5msIncrements = pValue[ROBOROACH_CONFIG_OFS_DURATION];
+  rrCharRandomMode = pValue[ROBOROACH_CONFIG_OFS_RANDOM_MODE];
+  rrCharGain = pValue[ROBOROACH_CONFIG_OFS_GAIN];
+  rrCharFreqMin = pValue[ROBOROACH_CONFIG_OFS_FREQ_MIN];
+  rrCharFreqMax = pValue[ROBOROACH_CONFIG_OFS_FREQ_MAX];
+  rrCharPWmin = pValue[ROBOROACH_CONFIG_OFS_PW_MIN];
+  rrCharPWmax = pValue[ROBOROACH_CONFIG_OFS_PW_MAX];
+  rrCharGainMin = pValue[ROBOROACH_CONFIG_OFS_GAIN_MIN];
+  rrCharGainMax = pValue[ROBOROACH_CONFIG_OFS_GAIN_MAX];
+  rrCharPulseWidthUs = BUILD_UINT16( pValue[ROBOROACH_CONFIG_OFS_PULSE_WIDTH_US],
+                                     pValue[ROBOROACH_CONFIG_OFS_PULSE_WIDTH_US + 1] );
+  rrCharPeriodUs = BUILD_UINT16( pValue[ROBOROACH_CONFIG_OFS_PERIOD_US],
+                                 pValue[ROBOROACH_CONFIG_OFS_PERIOD_US + 1] );
+
+  //Derived values once for the whole set
+  roboRoachProfile_updateStimulationSettings();
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn          roboRoachProfile_UploadPreset
+ *
+ * @brief       Store a Preset Upload value: the slot number followed by a
+ *              Stimulation Config value, saved to the slot's SNV item.
+ *
+ * @param       pValue - slot and packed parameters
+ * @param       len - length of pValue
+ *
+ * @return      SUCCESS, ATT_ERR_INVALID_VALUE_SIZE, ATT_ERR_INVALID_VALUE
+ *              (no such slot or unknown version) or
+ *              ATT_ERR_INSUFFICIENT_RESOURCES (SNV write failed)
+ */
+static bStatus_t roboRoachProfile_UploadPreset( uint8 *pValue, uint8 len )
+{
+  if ( len != ROBOROACH_PRESET_UPLOAD_LEN )
+  {
+    return ( ATT_ERR_INVALID_VALUE_SIZE );
+  }
+  if ( ( pValue[0] >= ROBOROACH_NUM_PRESETS ) ||
+       ( pValue[1 + ROBOROACH_CONFIG_OFS_VERSION] != ROBOROACH_CONFIG_VERSION ) )
+  {
+    return ( ATT_ERR_INVALID_VALUE );
+  }
+  if ( osal_snv_write( ROBOROACH_NV_PRESET_FIRST + pValue[0], ROBOROACH_CONFIG_LEN,
+                       &pValue[1] ) != SUCCESS )
+  {
+    return ( ATT_ERR_INSUFFICIENT_RESOURCES );
+  }
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn          roboRoachProfile_LoadPreset
+ *
+ * @brief       Apply the parameters stored in a preset slot and make it
+ *              the Active Preset.
+ *
+ * @param       slot - preset slot, below ROBOROACH_NUM_PRESETS
+ *
+ * @return      SUCCESS or ATT_ERR_INVALID_VALUE (no such slot, nothing
+ *              uploaded to it or unknown version)
+ */
+static bStatus_t roboRoachProfile_LoadPreset( uint8 slot )
+{
+  uint8 config[ROBOROACH_CONFIG_LEN];
+
+  if ( ( slot >= ROBOROACH_NUM_PRESETS ) ||
+       ( osal_snv_read( ROBOROACH_NV_PRESET_FIRST + slot, ROBOROACH_CONFIG_LEN, config ) != SUCCESS ) ||
+       ( roboRoachProfile_UnpackConfig( config, ROBOROACH_CONFIG_LEN ) != SUCCESS ) )
+  {
+    return ( ATT_ERR_INVALID_VALUE );
+  }
+  rrCharActivePreset = slot;
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachProfile_SetStatus
+ *
+ * @brief   Update the Stimulation Status characteristic and notify the
+ *          clients that enabled it. Every update gets the next sequence
+ *          number, so a client can tell when it missed one.
+ *
+ * @param   event - ROBOROACH_STATUS_STARTED, _FINISHED, _REJECTED or _QUEUED
+ * @param   isLeft - 1 for the left side, 0 for the right
+ * @param   queued - commands waiting in the stimulation queue
+ *
+ * @return  none
+ */
+void RoboRoachProfile_SetStatus( uint8 event, uint8 isLeft, uint8 queued )
+{
+  rrCharStatus[0]++;
+  rrCharStatus[1] = event;
+  rrCharStatus[2] = isLeft;
+  rrCharStatus[3] = queued;
+
+  GATTServApp_ProcessCharCfg( rrCharStatusConfig, rrCharStatus, FALSE,
+                              roboRoachAttrTbl, GATT_NUM_ATTRS( roboRoachAttrTbl ),
+                              INVALID_TASK_ID );
+}
+
+/*********************************************************************
+ * @fn      RoboRoachProfile_GetCommand
+ *
+ * @brief   Take the oldest stimulate command written by the client.
+ *
+ * @param   pIsLeft - set to 1 for a left command, 0 for a right one
+ *
+ * @return  TRUE if a command was taken, FALSE if none is waiting
+ */
+bool RoboRoachProfile_GetCommand( uint8 *pIsLeft )
+{
+  if ( rrCommandInboxCount == 0 )
+  {
+    return ( FALSE );
+  }
+  *pIsLeft = rrCommandInbox[rrCommandInboxHead];
+  rrCommandInboxHead = ( rrCommandInboxHead + 1 ) % ROBOROACH_COMMAND_INBOX_LEN;
+  rrCommandInboxCount--;
+  return ( TRUE );
+}
+
 /*********************************************************************
  * @fn          roboRoachProfile_Stimulate
  * 
@@ -885,18 +1553,37 @@ static void roboRoachProfile_updateStimulationSettings( void )
  * Turns on indicator LED
  * Sets the timer to turn off Stimulation and LEDs 
  * 
+ * The command is kept in the inbox so that commands written in the same
+ * connection event are all seen, in order. A full inbox drops it. The
+ * application is told at once and can start the train from here; the
+ * task event follows for the rest of its work.
+ * 
  * parameter:  uuid = ROBOROACH_CHAR_STIMULATE_LEFT_UUID or 
- *                    ROBOROACH_CHAR_STIMULATE_RIGHT_UUID
+ *                    ROBOROACH_CHAR_STIMULATE_RIGHT_UUID (or the
+ *                    ROBOROACH_STIMULATE_LEFT/RIGHT parameter IDs)
  */
 static void roboRoachProfile_Stimulate( uint16 uuid )
 {
-   if (uuid == ROBOROACH_CHAR_STIMULATE_LEFT_UUID)
+   uint8 isLeft = ( uuid == ROBOROACH_CHAR_STIMULATE_LEFT_UUID ) || ( uuid == ROBOROACH_STIMULATE_LEFT );
+   
+   RoboRoachLatency_Mark( ROBOROACH_LATENCY_WRITE );
+
+   if ( rrCommandInboxCount < ROBOROACH_COMMAND_INBOX_LEN )
    {
-     osal_start_timerEx( roboRoachApp_TaskID, BYB_STIMULATE_LEFT_EVT, 1 );
+     rrCommandInbox[( rrCommandInboxHead + rrCommandInboxCount ) % ROBOROACH_COMMAND_INBOX_LEN] = isLeft;
+     rrCommandInboxCount++;
    }
    else
    {
-     osal_start_timerEx( roboRoachApp_TaskID, BYB_STIMULATE_RIGHT_EVT, 1 );  
+     RoboRoachProfile_SetStatus( ROBOROACH_STATUS_REJECTED, isLeft, rrCharStatus[3] );
+     return;
+   }
+   
+   osal_set_event( roboRoachApp_TaskID, isLeft ? BYB_STIMULATE_LEFT_EVT : BYB_STIMULATE_RIGHT_EVT );
+
+   if ( roboRoach_AppCBs && roboRoach_AppCBs->pfnRoboRoachProfileChange )
+   {
+     roboRoach_AppCBs->pfnRoboRoachProfileChange( isLeft ? ROBOROACH_STIMULATE_LEFT : ROBOROACH_STIMULATE_RIGHT );
    }
         
 }
@@ -921,7 +1608,7 @@ static void roboRoachProfile_HandleConnStatusCB( uint16 connHandle, uint8 change
          ( ( changeType == LINKDB_STATUS_UPDATE_STATEFLAGS ) && 
            ( !linkDB_Up( connHandle ) ) ) )
     { 
-      //GATTServApp_InitCharCfg( connHandle, rrCharStimulateLeftConfig );
+      GATTServApp_InitCharCfg( connHandle, rrCharStatusConfig );
     }
   }
 }
@@ -29,11 +29,33 @@ extern "C"
 // Callback when a characteristic value has changed
 typedef NULL_OK void (*roboRoachProfileChange_t)( uint8 paramID );
 
+// Callback to fill a read of the Event Statistics characteristic; returns the length
+typedef NULL_OK uint8 (*roboRoachProfileReadStats_t)( uint8 *pValue, uint16 offset, uint8 maxLen );
+
 typedef struct
 {
   roboRoachProfileChange_t        pfnRoboRoachProfileChange;  // Called when characteristic value changes
+  roboRoachProfileReadStats_t     pfnRoboRoachProfileReadStats;  // Called when event statistics are read
 } roboRoachProfileCBs_t;
 
+// One consistent copy of every stimulation parameter
+typedef struct
+{
+  uint16 periodMs;          // from the frequency
+  uint16 periodUs;          // 0 = from the frequency
+  uint16 pulseWidthUs;      // 0 = from the ms pulse width
+  uint8  pulseWidth;        // ms
+  uint8  duration;          // 5 ms increments
+  uint8  randomMode;
+  uint8  gain;              // %
+  uint8  freqMin;
+  uint8  freqMax;
+  uint8  pwMin;
+  uint8  pwMax;
+  uint8  gainMin;
+  uint8  gainMax;
+} roboRoachParams_t;
+
   
 /*********************************************************************
  * MACROS
@@ -87,6 +109,31 @@ extern bStatus_t RoboRoachProfile_SetParameter( uint8 param, uint8 len, void *va
  */
 extern bStatus_t RoboRoachProfile_GetParameter( uint8 param, void *value );
 
+/*
+ * RoboRoach_GetParams - Copy every stimulation parameter at once.
+ *
+ *    pParams - set to the current characteristic values
+ */
+extern void RoboRoachProfile_GetParams( roboRoachParams_t *pParams );
+
+/*
+ * RoboRoach_GetCommand - Take the oldest stimulate command written by the
+ *          client. Returns FALSE when none is waiting.
+ *
+ *    pIsLeft - set to 1 for a left command, 0 for a right one
+ */
+extern bool RoboRoachProfile_GetCommand( uint8 *pIsLeft );
+
+/*
+ * RoboRoach_SetStatus - Update the Stimulation Status characteristic and
+ *          notify it.
+ *
+ *    event - ROBOROACH_STATUS_STARTED, _FINISHED, _REJECTED or _QUEUED
+ *    isLeft - 1 for the left side, 0 for the right
+ *    queued - commands waiting in the stimulation queue
+ */
+extern void RoboRoachProfile_SetStatus( uint8 event, uint8 isLeft, uint8 queued );
+
 /*********************************************************************
 *********************************************************************/
 